@@ -0,0 +1,252 @@
+/*
+ * Discovery latency at scale, over a simulated network.
+ *
+ * For each number of providers given on the command line (10, 100 and 1000
+ * by default), the benchmark measures:
+ *
+ *  - publish: from Provider::update() to serviceAdded on a browser that is
+ *    already running, which includes the hostname and service probes;
+ *  - browse:  from the construction of a new browser to serviceAdded for
+ *    each of the services already published;
+ *  - update:  from Provider::update() with new attributes to serviceUpdated
+ *    on that browser.
+ *
+ * Each phase reports the p50, p99 and maximum latencies, the services that
+ * were not seen before the timeout, the packets put on the network and the
+ * CPU time of the process. The network settles between phases, so that the
+ * packets of a phase are only its own.
+ *
+ * Usage: bench-discovery [providers...]
+ */
+
+#include <qtmdns/browser.hpp>
+#include <qtmdns/hostname.hpp>
+#include <qtmdns/localserver.hpp>
+#include <qtmdns/provider.hpp>
+#include <qtmdns/service.hpp>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHash>
+#include <QHostAddress>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const QByteArray ServiceType = "_bench._tcp.local.";
+
+// Longest a phase may take, and how long the network has to be silent before
+// the next phase starts (announcements are repeated up to 3 s apart)
+constexpr qint64 PhaseTimeout = 120 * 1000;
+constexpr qint64 QuietPeriod = 4 * 1000;
+constexpr qint64 QuietTimeout = 60 * 1000;
+
+// One host on the simulated network, publishing a single service
+struct Host
+{
+    Host(QtMdns::LocalNetwork* network, int index) :
+        server(network, QHostAddress(quint32(0x0a000000 + 2 + index))),
+        hostname(&server, "bench-host-" + QByteArray::number(index)),
+        provider(&server, &hostname)
+    {
+        service.setName("Bench service " + QByteArray::number(index));
+        service.setType(ServiceType);
+        service.setPort(quint16(1024 + index));
+    }
+
+    QtMdns::LocalServer server;
+    QtMdns::Hostname hostname;
+    QtMdns::Provider provider;
+    QtMdns::Service service;
+};
+
+// Run the event loop until done() returns true or the timeout expires
+bool runUntil(std::function<bool()> const& done, qint64 timeout)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (done() || elapsed.hasExpired(timeout))
+            loop.quit();
+    });
+    poll.start(5);
+    loop.exec();
+    return done();
+}
+
+void waitForQuiet(QtMdns::LocalNetwork const& network)
+{
+    quint64 packets = network.packetsSent();
+    QElapsedTimer silence;
+    silence.start();
+    runUntil([&]() {
+        if (network.packetsSent() != packets) {
+            packets = network.packetsSent();
+            silence.restart();
+        }
+        return silence.hasExpired(QuietPeriod);
+    }, QuietTimeout);
+}
+
+double cpuMsecs()
+{
+    return 1000.0 * double(std::clock()) / CLOCKS_PER_SEC;
+}
+
+// Latencies of the services of a phase, by service name
+class Phase
+{
+public:
+    Phase(char const* name, QtMdns::LocalNetwork& network, int expected) :
+        name(name),
+        network(network),
+        expected(expected)
+    {
+        network.resetCounters();
+        cpuStart = cpuMsecs();
+        clock.start();
+    }
+
+    void record(QByteArray const& service)
+    {
+        if ( ! latencies.contains(service))
+            latencies.insert(service, clock.elapsed());
+    }
+
+    bool isComplete() const
+    {
+        return latencies.size() >= expected;
+    }
+
+    void report(int providers) const
+    {
+        std::vector<qint64> values;
+        for (auto it = latencies.cbegin(); it != latencies.cend(); ++it)
+            values.push_back(it.value());
+        std::sort(values.begin(), values.end());
+
+        // Nearest-rank percentiles
+        auto const percentile = [&values](int p) -> qint64 {
+            if (values.empty())
+                return -1;
+            std::size_t const rank = (values.size() * std::size_t(p) + 99) / 100;
+            return values.at(std::max<std::size_t>(rank, 1) - 1);
+        };
+
+        std::printf("%9d  %-8s %8lld %8lld %8lld %8d %9llu %9.0f\n",
+                    providers, name,
+                    static_cast<long long>(percentile(50)),
+                    static_cast<long long>(percentile(99)),
+                    static_cast<long long>(values.empty() ? -1 : values.back()),
+                    expected - static_cast<int>(values.size()),
+                    static_cast<unsigned long long>(network.packetsSent()),
+                    cpuMsecs() - cpuStart);
+        std::fflush(stdout);
+    }
+
+private:
+    char const* name;
+    QtMdns::LocalNetwork& network;
+    int expected;
+    QElapsedTimer clock;
+    double cpuStart {0};
+    QHash<QByteArray, qint64> latencies;
+};
+
+void run(int providers)
+{
+    // The network is declared first, to outlive its servers
+    QtMdns::LocalNetwork network;
+    network.setLatency(1);
+
+    QtMdns::LocalServer observerServer(&network, QHostAddress(quint32(0x0a000001)));
+    QtMdns::Browser observer(&observerServer, ServiceType);
+
+    std::vector<std::unique_ptr<Host>> hosts;
+    hosts.reserve(std::size_t(providers));
+    for (int i = 0; i < providers; ++i)
+        hosts.push_back(std::make_unique<Host>(&network, i));
+
+    {
+        Phase phase("publish", network, providers);
+        QObject::connect(&observer, &QtMdns::Browser::serviceAdded, &observer,
+                         [&phase](QtMdns::Service const& service) { phase.record(service.name()); });
+        for (auto const& host : hosts)
+            host->provider.update(host->service);
+
+        runUntil([&phase]() { return phase.isComplete(); }, PhaseTimeout);
+        phase.report(providers);
+        QObject::disconnect(&observer, nullptr, &observer, nullptr);
+    }
+    waitForQuiet(network);
+
+    QtMdns::LocalServer browserServer(&network, QHostAddress(quint32(0x0a0000ff)));
+    std::unique_ptr<QtMdns::Browser> browser;
+    {
+        Phase phase("browse", network, providers);
+        browser = std::make_unique<QtMdns::Browser>(&browserServer, ServiceType);
+        QObject::connect(browser.get(), &QtMdns::Browser::serviceAdded, browser.get(),
+                         [&phase](QtMdns::Service const& service) { phase.record(service.name()); });
+
+        runUntil([&phase]() { return phase.isComplete(); }, PhaseTimeout);
+        phase.report(providers);
+        QObject::disconnect(browser.get(), nullptr, browser.get(), nullptr);
+    }
+    waitForQuiet(network);
+
+    {
+        Phase phase("update", network, providers);
+        QObject::connect(browser.get(), &QtMdns::Browser::serviceUpdated, browser.get(),
+                         [&phase](QtMdns::Service const& service) {
+            // Only the new attributes count, not other changes of the service
+            if (service.attributes().value("rev") == "2")
+                phase.record(service.name());
+        });
+        for (auto const& host : hosts) {
+            host->service.setAttributes({{"rev", "2"}});
+            host->provider.update(host->service);
+        }
+
+        runUntil([&phase]() { return phase.isComplete(); }, PhaseTimeout);
+        phase.report(providers);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QList<int> counts;
+    QStringList const arguments = QCoreApplication::arguments();
+    for (qsizetype i = 1; i < arguments.size(); ++i) {
+        bool ok = false;
+        int const count = arguments.at(i).toInt(&ok);
+        if ( ! ok || count <= 0) {
+            std::fprintf(stderr, "Usage: %s [providers...]\n", argv[0]);
+            return 1;
+        }
+        counts.append(count);
+    }
+    if (counts.isEmpty())
+        counts = {10, 100, 1000};
+
+    std::printf("%9s  %-8s %8s %8s %8s %8s %9s %9s\n",
+                "providers", "phase", "p50 ms", "p99 ms", "max ms", "missing", "packets", "cpu ms");
+    for (int const count : qAsConst(counts))
+        run(count);
+
+    return 0;
+}
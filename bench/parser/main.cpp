@@ -0,0 +1,254 @@
+/*
+ * Worst-case throughput of the packet decoder.
+ *
+ * A hostile host can send any packet it likes; what matters is how much CPU
+ * the decoder spends per byte received. Each scenario is decoded repeatedly
+ * for a while and its rate is reported in packets and megabytes per second:
+ *
+ *  - response:  a typical response of a provider, for reference;
+ *  - names:     a packet filled with questions for 255-byte names of 127
+ *               labels, the longest names allowed;
+ *  - chains:    a packet filled with questions whose names follow 128
+ *               compression pointers, the most allowed, to a 255-byte name;
+ *  - loop:      a name pointing to itself, rejected;
+ *  - oversized: a packet larger than 65535 bytes, rejected.
+ *
+ * With --min-rate, the program fails if a scenario decodes fewer megabytes
+ * per second than given, which makes it usable as a regression guard.
+ *
+ * Usage: bench-parser [--min-rate MB/s]
+ */
+
+#include <qtmdns/dns.hpp>
+#include <qtmdns/message.hpp>
+#include <qtmdns/query.hpp>
+#include <qtmdns/record.hpp>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QList>
+
+#include <cstdio>
+
+namespace {
+
+constexpr qint64 ScenarioDuration = 500;  // Milliseconds per scenario
+constexpr int MaxPacketSize = 0xffff;
+
+void append16(QByteArray& packet, quint16 value)
+{
+    packet.append(char(value >> 8));
+    packet.append(char(value & 0xff));
+}
+
+void appendHeader(QByteArray& packet, quint16 questions)
+{
+    append16(packet, 0);
+    append16(packet, 0);
+    append16(packet, questions);
+    append16(packet, 0);
+    append16(packet, 0);
+    append16(packet, 0);
+}
+
+// 127 labels of one byte: 255 bytes in wire format, with the root label
+QByteArray longestName()
+{
+    QByteArray name;
+    for (int i = 0; i < 127; ++i)
+        name.append("\x01" "a", 2);
+    name.append('\0');
+    return name;
+}
+
+void setQuestionCount(QByteArray& packet, int count)
+{
+    packet[4] = char(count >> 8);
+    packet[5] = char(count & 0xff);
+}
+
+QByteArray responsePacket()
+{
+    QtMdns::Message message;
+        message.setResponse(true);
+
+    QtMdns::Record ptr;
+    ptr.setName(QByteArray("_http._tcp.local."));
+    ptr.setType(QtMdns::PTR);
+    ptr.setTtl(4500);
+    ptr.setTarget(QByteArray("My Service._http._tcp.local."));
+    message.addRecord(ptr);
+
+    QtMdns::Record srv;
+    srv.setName(QByteArray("My Service._http._tcp.local."));
+    srv.setType(QtMdns::SRV);
+    srv.setFlushCache(true);
+    srv.setTtl(120);
+    srv.setPort(80);
+    srv.setTarget(QByteArray("my-host.local."));
+    message.addRecord(srv, QtMdns::Message::Additional);
+
+    QtMdns::Record txt;
+    txt.setName(QByteArray("My Service._http._tcp.local."));
+    txt.setType(QtMdns::TXT);
+    txt.setFlushCache(true);
+    txt.setTtl(4500);
+    txt.setAttributes({{"path", "/index.html"}, {"version", "1.2.3"}});
+    message.addRecord(txt, QtMdns::Message::Additional);
+
+    QtMdns::Record a;
+    a.setName(QByteArray("my-host.local."));
+    a.setType(QtMdns::A);
+    a.setFlushCache(true);
+    a.setTtl(120);
+    a.setAddress(QHostAddress("192.168.1.10"));
+    message.addRecord(a, QtMdns::Message::Additional);
+
+    QtMdns::Record aaaa = a;
+    aaaa.setType(QtMdns::AAAA);
+    aaaa.setAddress(QHostAddress("fe80::1"));
+    message.addRecord(aaaa, QtMdns::Message::Additional);
+
+    return QtMdns::toPacket(message);
+}
+
+QByteArray namesPacket()
+{
+    QByteArray packet;
+    appendHeader(packet, 0);
+
+    QByteArray const name = longestName();
+    int count = 0;
+    while (packet.size() + name.size() + 4 <= MaxPacketSize) {
+        packet.append(name);
+        append16(packet, QtMdns::A);
+        append16(packet, 1);
+        ++count;
+    }
+    setQuestionCount(packet, count);
+    return packet;
+}
+
+QByteArray chainsPacket()
+{
+    QByteArray packet;
+    appendHeader(packet, 0);
+
+    // A question for the longest name, then 127 questions each pointing to
+    // the name of the previous one, then as many questions as fit pointing
+    // to the end of the chain: 128 pointers to follow for each of them
+    qsizetype previous = packet.size();
+    packet.append(longestName());
+    append16(packet, QtMdns::A);
+    append16(packet, 1);
+    int count = 1;
+
+    for (int i = 0; i < 127; ++i) {
+        qsizetype const current = packet.size();
+        append16(packet, quint16(0xc000 | previous));
+        append16(packet, QtMdns::A);
+        append16(packet, 1);
+        previous = current;
+        ++count;
+    }
+
+    while (packet.size() + 6 <= MaxPacketSize) {
+        append16(packet, quint16(0xc000 | previous));
+        append16(packet, QtMdns::A);
+        append16(packet, 1);
+        ++count;
+    }
+    setQuestionCount(packet, count);
+    return packet;
+}
+
+QByteArray loopPacket()
+{
+    QByteArray packet;
+    appendHeader(packet, 1);
+    append16(packet, 0xc000 | 12);
+    append16(packet, QtMdns::A);
+    append16(packet, 1);
+    return packet;
+}
+
+QByteArray oversizedPacket()
+{
+    QByteArray packet;
+    appendHeader(packet, 1);
+    packet.append(QByteArray(MaxPacketSize + 1 - packet.size(), '\0'));
+    return packet;
+}
+
+// Decode the packet repeatedly and return the rate in megabytes per second
+double run(char const* name, QByteArray const& packet)
+{
+    QtMdns::ParseError error = QtMdns::ParseError::NoError;
+    quint64 packets = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        for (int i = 0; i < 16; ++i) {
+            QtMdns::Message message;
+            QtMdns::fromPacket(packet, message, error);
+        }
+        packets += 16;
+    } while ( ! timer.hasExpired(ScenarioDuration));
+
+    double const seconds = double(timer.nsecsElapsed()) / 1e9;
+    double const rate = double(packets) * double(packet.size()) / 1e6 / seconds;
+    std::printf("%-10s %7lld %12.0f %10.1f %10.2f  %s\n",
+                name, static_cast<long long>(packet.size()),
+                double(packets) / seconds, rate, seconds * 1e6 / double(packets),
+                error == QtMdns::ParseError::NoError ? "accepted" : "rejected");
+    std::fflush(stdout);
+    return rate;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    double minRate = 0;
+    QStringList const arguments = QCoreApplication::arguments();
+    if (arguments.size() == 3 && arguments.at(1) == "--min-rate") {
+        bool ok = false;
+        minRate = arguments.at(2).toDouble(&ok);
+        if ( ! ok) {
+            std::fprintf(stderr, "Invalid rate\n");
+            return 1;
+        }
+    } else if (arguments.size() != 1) {
+        std::fprintf(stderr, "Usage: %s [--min-rate MB/s]\n", argv[0]);
+        return 1;
+    }
+
+    struct Scenario
+    {
+        char const* name;
+        QByteArray packet;
+    };
+    QList<Scenario> const scenarios {
+        {"response", responsePacket()},
+        {"names", namesPacket()},
+        {"chains", chainsPacket()},
+        {"loop", loopPacket()},
+        {"oversized", oversizedPacket()},
+    };
+
+    std::printf("%-10s %7s %12s %10s %10s  %s\n", "scenario", "bytes", "packets/s", "MB/s", "us/packet", "result");
+
+    int result = 0;
+    for (Scenario const& scenario : scenarios) {
+        if (run(scenario.name, scenario.packet) < minRate) {
+            std::fprintf(stderr, "%s: below %.1f MB/s\n", scenario.name, minRate);
+            result = 1;
+        }
+    }
+    return result;
+}
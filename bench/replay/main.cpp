@@ -0,0 +1,271 @@
+/*
+ * Replay of mDNS captures through the decoder, a cache and browsers.
+ *
+ * Each capture given on the command line (pcap, pcapng or binary log) is
+ * replayed as fast as possible, with the cache following the capture
+ * timestamps. Without a capture, a synthetic one is generated: an office
+ * where a number of devices announce a few services each, query for their
+ * peers, and some of them leave.
+ *
+ * The benchmark reports the packets and messages replayed, the decode rate
+ * and the allocations made by the library during the run, counted by the
+ * operator new of this program.
+ *
+ * Only the work done for each packet is measured: the event loop does not
+ * run during a replay, so the timers of the browsers never fire. Services
+ * are not resolved from the cache in batches and no query is built, which
+ * leaves the browser counters at what the received packets alone produce.
+ *
+ * Usage: bench-replay [--devices N] [--type TYPE]... [capture...]
+ */
+
+#include <qtmdns/browser.hpp>
+#include <qtmdns/dns.hpp>
+#include <qtmdns/mdns.hpp>
+#include <qtmdns/message.hpp>
+#include <qtmdns/packettrace.hpp>
+#include <qtmdns/query.hpp>
+#include <qtmdns/record.hpp>
+#include <qtmdns/replayer.hpp>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QHostAddress>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<quint64> allocations {0};
+
+// Services of the synthetic devices, one of each per device
+const QList<QByteArray> DeviceTypes {
+    "_airplay._tcp.local.",
+    "_raop._tcp.local.",
+    "_companion-link._tcp.local.",
+};
+
+// Devices join over a minute, announce three times (RFC 6762 §8.3) and one
+// in ten says goodbye at the end
+constexpr qint64 JoinPeriod = 60 * 1000 * 1000;
+constexpr qint64 StartTime = 1700000000LL * 1000 * 1000;
+
+QtMdns::TracedPacket makePacket(qint64 timestamp, int device, QtMdns::Message const& message)
+{
+    QtMdns::TracedPacket packet;
+    packet.timestamp = timestamp;
+    packet.address = QHostAddress(quint32(0x0a000000 + 1 + device));
+    packet.port = QtMdns::mdnsDefaults().MdnsPort;
+    packet.data = QtMdns::toPacket(message);
+    return packet;
+}
+
+QList<QtMdns::Record> deviceRecords(int device, quint32 ttl)
+{
+    QByteArray const hostname = "device-" + QByteArray::number(device) + ".local.";
+    QList<QtMdns::Record> records;
+
+    for (QByteArray const& type : DeviceTypes) {
+        QByteArray const instance = "Device " + QByteArray::number(device) + "." + type;
+
+        // Service type enumeration (RFC 6763 §9), how a browser of
+        // MdnsBrowseType learns the types to browse
+        QtMdns::Record browsePtr;
+        browsePtr.setName(QtMdns::mdnsDefaults().MdnsBrowseType);
+        browsePtr.setType(QtMdns::PTR);
+        browsePtr.setTtl(ttl ? 4500 : 0);
+        browsePtr.setTarget(type);
+        records.append(browsePtr);
+
+        QtMdns::Record ptr;
+        ptr.setName(type);
+        ptr.setType(QtMdns::PTR);
+        ptr.setTtl(ttl ? 4500 : 0);
+        ptr.setTarget(instance);
+        records.append(ptr);
+
+        QtMdns::Record srv;
+        srv.setName(instance);
+        srv.setType(QtMdns::SRV);
+        srv.setFlushCache(true);
+        srv.setTtl(ttl);
+        srv.setPort(quint16(7000 + device % 1000));
+        srv.setTarget(hostname);
+        records.append(srv);
+
+        QtMdns::Record txt;
+        txt.setName(instance);
+        txt.setType(QtMdns::TXT);
+        txt.setFlushCache(true);
+        txt.setTtl(ttl ? 4500 : 0);
+        txt.setAttributes({{"model", "Bench" + QByteArray::number(device % 7)},
+                           {"id", QByteArray::number(device)}});
+        records.append(txt);
+    }
+
+    QtMdns::Record a;
+    a.setName(hostname);
+    a.setType(QtMdns::A);
+    a.setFlushCache(true);
+    a.setTtl(ttl);
+    a.setAddress(QHostAddress(quint32(0x0a000000 + 1 + device)));
+    records.append(a);
+
+    return records;
+}
+
+QList<QtMdns::TracedPacket> synthesize(int devices)
+{
+    QList<QtMdns::TracedPacket> packets;
+    for (int device = 0; device < devices; ++device) {
+        qint64 const joined = StartTime + JoinPeriod * device / devices;
+
+        // Browse for the services of the peers, with the known answers
+        QtMdns::Message query;
+        for (QByteArray const& type : DeviceTypes) {
+            QtMdns::Query question;
+                question.setName(type);
+                question.setType(QtMdns::PTR);
+            query.addQuery(question);
+        }
+        packets.append(makePacket(joined, device, query));
+
+        QtMdns::Message announcement;
+            announcement.setResponse(true);
+        const auto records = deviceRecords(device, 120);
+        for (QtMdns::Record const& record : records)
+            announcement.addRecord(record);
+        for (qint64 const delay : {0LL, 1000LL * 1000, 3000LL * 1000})
+            packets.append(makePacket(joined + 250 * 1000 + delay, device, announcement));
+    }
+
+    for (int device = 0; device < devices; device += 10) {
+        QtMdns::Message goodbye;
+            goodbye.setResponse(true);
+        const auto records = deviceRecords(device, 0);
+        for (QtMdns::Record const& record : records)
+            goodbye.addRecord(record);
+        packets.append(makePacket(StartTime + JoinPeriod + 10 * 1000 * 1000, device, goodbye));
+    }
+
+    std::stable_sort(packets.begin(), packets.end(), [](QtMdns::TracedPacket const& a, QtMdns::TracedPacket const& b) {
+        return a.timestamp < b.timestamp;
+    });
+    return packets;
+}
+
+void report(char const* name, QtMdns::ReplayStatistics const& stats)
+{
+    std::printf("%s\n", name);
+    std::printf("  packets         %llu (%llu bytes), %llu rejected\n",
+                static_cast<unsigned long long>(stats.packets),
+                static_cast<unsigned long long>(stats.bytes),
+                static_cast<unsigned long long>(stats.parseFailures));
+    std::printf("  messages        %llu, %llu records\n",
+                static_cast<unsigned long long>(stats.messages),
+                static_cast<unsigned long long>(stats.records));
+    std::printf("  capture         %.1f s, replayed in %.1f ms\n",
+                double(stats.captureDuration) / 1e6, double(stats.elapsed) / 1e6);
+    std::printf("  rate            %.0f messages/s\n", stats.messagesPerSecond);
+    std::printf("  allocations     %llu (%.1f per message)\n",
+                static_cast<unsigned long long>(stats.allocations),
+                stats.messages ? double(stats.allocations) / double(stats.messages) : 0.0);
+    std::printf("  cache           %llu records, %llu expirations\n",
+                static_cast<unsigned long long>(stats.cache.records),
+                static_cast<unsigned long long>(stats.cache.expirations));
+    std::printf("  browsers        %llu services added, %llu removed\n",
+                static_cast<unsigned long long>(stats.browsers.servicesAdded),
+                static_cast<unsigned long long>(stats.browsers.servicesRemoved));
+    std::fflush(stdout);
+}
+
+QtMdns::ReplayStatistics replay(QList<QByteArray> const& types, QList<QtMdns::TracedPacket> const& packets)
+{
+    QtMdns::Replayer replayer;
+    replayer.setAllocationCounter([]() { return allocations.load(std::memory_order_relaxed); });
+    for (QByteArray const& type : types)
+        replayer.addBrowser(type);
+    return replayer.replay(packets);
+}
+
+} // namespace
+
+// Count every allocation of the program, which is the library's during a replay
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* const p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int devices = 2000;
+    QList<QByteArray> types;
+    QStringList captures;
+
+    QStringList const arguments = QCoreApplication::arguments();
+    for (qsizetype i = 1; i < arguments.size(); ++i) {
+        QString const& argument = arguments.at(i);
+        if ((argument == "--devices" || argument == "--type") && i + 1 < arguments.size()) {
+            QString const& value = arguments.at(++i);
+            if (argument == "--type") {
+                types.append(value.toUtf8());
+                continue;
+            }
+
+            bool ok = false;
+            devices = value.toInt(&ok);
+            if ( ! ok || devices <= 0) {
+                std::fprintf(stderr, "Invalid number of devices\n");
+                return 1;
+            }
+        } else if (argument.startsWith("--")) {
+            std::fprintf(stderr, "Usage: %s [--devices N] [--type TYPE]... [capture...]\n", argv[0]);
+            return 1;
+        } else {
+            captures.append(argument);
+        }
+    }
+
+    // Browse everything by default, as a shared cache on a busy network would
+    if (types.isEmpty())
+        types.append(QtMdns::mdnsDefaults().MdnsBrowseType);
+
+    if (captures.isEmpty()) {
+        QList<QtMdns::TracedPacket> const packets = synthesize(devices);
+        QByteArray const name = "synthetic office, " + QByteArray::number(devices) + " devices";
+        report(name.constData(), replay(types, packets));
+        return 0;
+    }
+
+    int result = 0;
+    for (QString const& capture : qAsConst(captures)) {
+        QFile file(capture);
+        QList<QtMdns::TracedPacket> packets;
+        if ( ! file.open(QIODevice::ReadOnly) || ! QtMdns::PacketTrace::readCapture(&file, packets)) {
+            std::fprintf(stderr, "%s: cannot read capture\n", qPrintable(capture));
+            result = 1;
+            continue;
+        }
+        report(qPrintable(capture), replay(types, packets));
+    }
+    return result;
+}
@@ -0,0 +1,42 @@
+/*
+ * libFuzzer target for the packet decoder.
+ *
+ * Every input is decoded with fromPacket(). A decoded message is encoded
+ * again and must decode once more, as long as the encoding still fits in a
+ * DNS message.
+ *
+ * The seeds in corpus/ cover a typical response, compression pointer loops
+ * and chains, the longest names and names just past the limits, section
+ * counts that would wrap, and a packet larger than 65535 bytes. Larger
+ * inputs than the libFuzzer default have to be allowed to reach that one:
+ *
+ *     fuzz-packet -max_len=65536 corpus/
+ */
+
+#include <qtmdns/dns.hpp>
+#include <qtmdns/message.hpp>
+
+#include <QByteArray>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    // Raw rdata references the packet it was decoded from, keep a copy
+    QByteArray const packet(reinterpret_cast<const char*>(data), static_cast<qsizetype>(size));
+
+    QtMdns::Message message;
+    QtMdns::ParseError error;
+    if ( ! QtMdns::fromPacket(packet, message, error))
+        return 0;
+
+    QByteArray const encoded = QtMdns::toPacket(message);
+    if (encoded.size() <= 0xffff) {
+        QtMdns::Message decoded;
+        if ( ! QtMdns::fromPacket(encoded, decoded, error))
+            std::abort();
+    }
+    return 0;
+}
@@ -1,13 +1,21 @@
 #pragma once
 
 #include <QObject>
+#include <QScopedPointer>
 
 #include "qtmdns_export.hpp"
 
+#include <qtmdns/packettrace.hpp>
+#include <qtmdns/statistics.hpp>
+
+#include <memory>
+
 namespace QtMdns {
 
 class Message;
 
+class QTMDNS_EXPORT AbstractServerPrivate;
+
 /**
  * @brief Base class for sending and receiving DNS messages
  *
@@ -15,6 +23,11 @@ class Message;
  * receive DNS messages. By having them use this base class, they become far
  * easier to test. Any class derived from this one that implements the pure
  * virtual methods can be used for sending and receiving DNS messages.
+ *
+ * The base class also keeps the traffic counters of the server. They are
+ * updated by derived classes and by the components using the server, and can
+ * be read at any time with statistics() or periodically through the
+ * statisticsUpdated() signal.
  */
 class QTMDNS_EXPORT AbstractServer : public QObject
 {
@@ -38,6 +51,57 @@ public:
      */
     virtual void sendMessageToAll(Message const& message) = 0;
 
+    /**
+     * @brief Withdraw all the records published through the server
+     *
+     * Goodbye records, with a TTL of 0, are sent right away for the records
+     * of every provider and hostname using the server, packed in as few
+     * messages as possible, so peers drop them from their caches instead of
+     * waiting for them to expire. Derived classes call this from their
+     * destructor, while they can still send messages; applications may call
+     * it earlier when shutting down.
+     */
+    void sendGoodbyes();
+
+    /**
+     * @brief Retrieve a snapshot of the server counters
+     *
+     * Counters are updated atomically, this method can be called from any
+     * thread.
+     */
+    ServerStatistics statistics() const;
+
+    /**
+     * @brief Reset all counters to zero
+     */
+    void resetStatistics();
+
+    /**
+     * @brief Set the interval of the statisticsUpdated() signal
+     * @param msecs interval in milliseconds, 0 to disable (the default)
+     */
+    void setStatisticsInterval(int msecs);
+
+    /**
+     * @brief Report records that were left out of a response
+     * @param count number of records not sent
+     *
+     * Responders call this when known-answer suppression removed records from
+     * a response.
+     */
+    void countSuppressedRecords(int count);
+
+    /**
+     * @brief Retrieve the packet trace attached to the server, if any
+     */
+    std::shared_ptr<PacketTrace> packetTrace() const;
+
+    /**
+     * @brief Record every datagram sent and received into a trace
+     * @param trace trace to fill, or null to stop tracing
+     */
+    void setPacketTrace(std::shared_ptr<PacketTrace> trace);
+
 Q_SIGNALS:
 
     /**
@@ -51,6 +115,56 @@ Q_SIGNALS:
      * @param message brief description of the error
      */
     void error(QString const& message);
+
+    /**
+     * @brief Periodic snapshot of the server counters
+     * @param statistics current counters
+     *
+     * Only emitted once enabled with setStatisticsInterval().
+     */
+    void statisticsUpdated(QtMdns::ServerStatistics const& statistics);
+
+protected:
+
+    /**
+     * @brief Count a datagram received on an interface
+     * @param size size of the datagram in bytes
+     * @param interfaceIndex index of the interface, 0 if unknown
+     */
+    void countPacketReceived(qsizetype size, int interfaceIndex = 0);
+
+    /**
+     * @brief Count a datagram sent on an interface
+     * @param size size of the datagram in bytes
+     * @param interfaceIndex index of the interface, 0 if unknown
+     * @param success false if the datagram could not be sent
+     */
+    void countPacketSent(qsizetype size, int interfaceIndex = 0, bool success = true);
+
+    /**
+     * @brief Count a received datagram that could not be decoded
+     */
+    void countParseFailure(ParseError reason);
+
+    /**
+     * @brief Count a decoded or sent message as a query or a response
+     */
+    void countMessage(Message const& message, bool sent);
+
+    /**
+     * @brief Record a datagram into the packet trace, if one is attached
+     * @param direction whether the datagram was received or sent
+     * @param packet raw DNS packet
+     * @param address source address when received, destination when sent
+     * @param port source port when received, destination port when sent
+     * @param interfaceIndex index of the interface, 0 if unknown
+     */
+    void tracePacket(TracedPacket::Direction direction, QByteArray const& packet,
+                     QHostAddress const& address, quint16 port, int interfaceIndex = 0);
+
+private:
+    Q_DECLARE_PRIVATE_D(dd_ptr, AbstractServer)
+    QScopedPointer<AbstractServerPrivate> dd_ptr;
 };
 
 } // namespace QtMdns
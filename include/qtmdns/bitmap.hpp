@@ -2,28 +2,33 @@
 
 #include "qtmdns_export.hpp"
 
-#include <QScopedPointer>
+#include <QtGlobal>
 
+#include <array>
 #include <vector>
 
 namespace QtMdns {
 
-class QTMDNS_EXPORT BitmapPrivate;
-
 /**
  * @brief 256-bit bitmap
  *
  * Bitmaps are used in QtMdns::NSEC records to indicate which records are
- * available. Bitmaps in mDNS records use only the first block (block 0).
+ * available. Bitmaps in mDNS records use only the first block (block 0), of
+ * at most 32 bytes, which is stored inline: bitmaps are plain values that
+ * never allocate.
+ *
+ * Bit 0 of the first byte is the most significant one and stands for type 0.
+ * The length of the block is the number of bytes up to the last one with a
+ * bit set.
  */
 class QTMDNS_EXPORT Bitmap
 {
 public:
-    Bitmap();
-    Bitmap(Bitmap const& other);
-    Bitmap& operator=(Bitmap const& other);
+    //! Largest length of a block, covering types 0 to 255
+    static constexpr size_t MaxLength = 32;
+
+    Bitmap() = default;
     bool operator==(Bitmap const& other) const;
-    ~Bitmap();
 
     /**
      * @brief Retrieve the length of the block in bytes
@@ -44,14 +49,28 @@ public:
      * @brief Set the data to be stored in the bitmap
      *
      * The length parameter indicates how many bytes of data are valid. The
-     * actual bytes are copied to the bitmap.
+     * actual bytes are copied to the bitmap, past MaxLength they are ignored.
      */
     void setData(quint8 length, quint8 const* data);
-    void setData(std::vector<quint8> data);
+    void setData(std::vector<quint8> const& data);
+
+    /**
+     * @brief Check if the bit of a type is set
+     *
+     * Types above 255 are never set.
+     */
+    bool contains(quint16 type) const;
+
+    /**
+     * @brief Set the bit of a type, extending the block as needed
+     *
+     * Types above 255 cannot be stored and are ignored.
+     */
+    void insert(quint16 type);
 
 private:
-    Q_DECLARE_PRIVATE_D(dd_ptr, Bitmap)
-    QScopedPointer<BitmapPrivate> dd_ptr;
+    std::array<quint8, MaxLength> bits {};
+    quint8 size {0};
 };
 
 } // namespace QtMdns
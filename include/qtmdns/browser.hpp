@@ -2,6 +2,8 @@
 
 #include "qtmdns_export.hpp"
 
+#include <qtmdns/statistics.hpp>
+
 #include <QByteArray>
 #include <QObject>
 #include <QScopedPointer>
@@ -19,7 +21,9 @@ class QTMDNS_EXPORT BrowserPrivate;
  *
  * This class provides a simple way to discover services on the local network.
  * A cache may be provided in the constructor to store records for future
- * queries.
+ * queries. Services already in that cache, found by other browsers or by
+ * observing responses (see Cache::observe()), are reported as soon as the
+ * browser starts, without waiting for responses.
  *
  * To browse for services of any type:
  *
@@ -27,6 +31,11 @@ class QTMDNS_EXPORT BrowserPrivate;
  * QtMdns::Browser browser(&server, QtMdns::MdnsBrowseType);
  * @endcode
  *
+ * The browser then enumerates the service types on the network and browses
+ * for the instances of each of them. It keeps an index of the instances of
+ * each type, to which SRV and TXT records must belong to be considered. The
+ * instances of types found close together are queried in the same message.
+ *
  * To browse for services of a specific type:
  *
  * @code
@@ -43,6 +52,12 @@ class QTMDNS_EXPORT BrowserPrivate;
  *
  * The serviceUpdated() and serviceRemoved() signals are emitted when services
  * are updated (their properties change) or are removed, respectively.
+ *
+ * Queries are repeated as RFC 6762 §5.2 describes: one second after the
+ * first, then at intervals doubling up to an hour. A query is skipped when
+ * another host just asked the same question with no known answer the
+ * browser lacks, as the responses to that host serve the browser as well
+ * (RFC 6762 §7.3).
  */
 class QTMDNS_EXPORT Browser : public QObject
 {
@@ -64,6 +79,11 @@ public:
 
     void startLookup(QByteArray type);
 
+    /**
+     * @brief Retrieve a snapshot of the browser counters
+     */
+    BrowserStatistics statistics() const;
+
 Q_SIGNALS:
     /**
      * @brief Indicate that a new service has been added
@@ -2,12 +2,19 @@
 
 #include "qtmdns_export.hpp"
 
+#include <qtmdns/domainname.hpp>
+#include <qtmdns/statistics.hpp>
+
+#include <QDateTime>
 #include <QList>
 #include <QObject>
 #include <QScopedPointer>
 
+#include <functional>
+
 namespace QtMdns {
 
+class AbstractServer;
 class Record;
 
 class QTMDNS_EXPORT CachePrivate;
@@ -36,6 +43,22 @@ class QTMDNS_EXPORT CachePrivate;
  * @endcode
  *
  * Alternatively, lookupRecord() can be used to find a single record.
+ *
+ * A cache shared by several browsers and resolvers can also observe all the
+ * responses received by a server with observe(). Every record is then
+ * cached, not only those a browser or resolver asked for, so that new ones
+ * find what they look for right away, such as the addresses sent along
+ * with a service. Observed records are not renewed: shouldQuery() is only
+ * emitted for records added with addRecord(), or kept with retainRecord()
+ * once a browser or resolver uses them. The memory they use is capped with
+ * setObservedMemoryLimit(); past the limit, the observed records closest to
+ * expiry are dropped first, and recordExpired() is emitted for them.
+ *
+ * NSEC records are negative answers: they list the types of records that
+ * exist for a name, asserting that no other does. Until they expire,
+ * isNegative() tells which records are not worth querying, and
+ * lookupRecord() returns without searching for them. NSEC records are not
+ * renewed: shouldQuery() is never emitted for them.
  */
 class QTMDNS_EXPORT Cache : public QObject
 {
@@ -58,6 +81,46 @@ public:
      */
     void addRecord(const Record &record);
 
+    /**
+     * @brief Cache every record of the responses received by a server
+     * @param server server to observe, or null to stop observing
+     */
+    void observe(AbstractServer* server);
+
+    /**
+     * @brief Schedule the timeouts of the cache with those of a server
+     * @param server server to share timeouts with, or null for a timer of the cache's own
+     *
+     * Timeouts of the components of a server share wakeups. Browsers and
+     * resolvers do this for the caches they create, and observe() for the
+     * observed server. A cache shared by several servers can only use one of
+     * them.
+     */
+    void setTimerServer(AbstractServer* server);
+
+    /**
+     * @brief Set the maximum memory used by the observed records of the cache
+     * @param bytes limit in bytes
+     *
+     * The size of a record is estimated from its uncompressed wire format,
+     * plus the bookkeeping of the cache, as records of a response can be a
+     * few bytes (A records) or a few kilobytes (TXT records). Records added
+     * with addRecord() or retained do not count toward the limit and are
+     * never dropped to make room. The default limit is 1 MiB.
+     */
+    void setObservedMemoryLimit(qsizetype bytes);
+
+    /**
+     * @brief Keep an observed record renewed, as if it had been added with addRecord()
+     * @param record record found in the cache
+     *
+     * Browsers and resolvers call this for the observed records they report:
+     * those are then never evicted, and shouldQuery() is emitted for them
+     * before they expire. The expiration of the record is not changed.
+     * Nothing is done for other records.
+     */
+    void retainRecord(const Record &record);
+
     /**
      * @brief Retrieve a single record from the cache
      * @param name name of record to retrieve or null for any
@@ -70,6 +133,7 @@ public:
      * record. Use lookupRecords() to obtain all of the records.
      */
     bool lookupRecord(const QByteArray &name, quint16 type, Record &record) const;
+    bool lookupRecord(DomainName const& name, quint16 type, Record &record) const;
 
     /**
      * @brief Retrieve multiple records from the cache
@@ -77,8 +141,50 @@ public:
      * @param type type of records to retrieve or ANY for all types
      * @param records storage for the records retrieved
      * @return true if records were retrieved
+     *
+     * Records whose name is the given name or one of its subdomains are
+     * retrieved. Names are compared without regard to the case of ASCII
+     * letters.
      */
     bool lookupRecords(const QByteArray &name, quint16 type, QList<Record> &records) const;
+    bool lookupRecords(DomainName const& name, quint16 type, QList<Record> &records) const;
+
+    /**
+     * @brief Check if a cached NSEC record asserts that a record does not exist
+     * @param name name of the record
+     * @param type type of the record
+     * @return true if no record of this type exists for the name
+     *
+     * A record added later with that name and type replaces the negative
+     * answer.
+     */
+    bool isNegative(const QByteArray &name, quint16 type) const;
+    bool isNegative(DomainName const& name, quint16 type) const;
+
+    /**
+     * @brief Use an external clock instead of the system time
+     * @param clock function returning the current time, or null for the system clock
+     *
+     * With an external clock the cache does not start any timer: triggers
+     * and expirations are only evaluated when processTimeouts() is called.
+     * This lets captures be replayed faster than real time with their
+     * original timing.
+     */
+    void setClock(std::function<QDateTime()> clock);
+
+    /**
+     * @brief Emit the signals of the triggers that have passed and purge expired records
+     *
+     * This is done automatically when using the system clock. Nothing is
+     * evaluated before the earliest trigger is due, so calling it for every
+     * tick of the external clock is cheap.
+     */
+    void processTimeouts();
+
+    /**
+     * @brief Retrieve a snapshot of the cache counters
+     */
+    CacheStatistics statistics() const;
 
 Q_SIGNALS:
 
@@ -3,10 +3,12 @@
 #include "qtmdns_export.hpp"
 
 #include <QByteArray>
+#include <QList>
 #include <QMap>
 
 namespace QtMdns {
 
+class DomainName;
 class Message;
 class Record;
 
@@ -17,8 +19,12 @@ enum {
     AAAA = 28,
     /// Wildcard for cache lookups
     ANY = 255,
+    /// Canonical name for an alias
+    CNAME = 5,
     /// List of records
     NSEC = 47,
+    /// Authoritative name server
+    NS = 2,
     /// Pointer to hostname
     PTR = 12,
     /// %Service information
@@ -27,18 +33,57 @@ enum {
     TXT = 16
 };
 
+/**
+ * @brief Reason for rejecting a raw DNS packet
+ */
+enum class ParseError : quint8 {
+    /// The packet was decoded successfully
+    NoError,
+    /// The packet is shorter than the DNS header
+    TruncatedHeader,
+    /// A question is truncated
+    InvalidQuery,
+    /// A name is truncated, malformed or uses an unsupported label type
+    InvalidName,
+    /// A record is truncated or its data is malformed
+    InvalidRecord,
+    /// A name is longer than 255 bytes or 128 labels
+    NameTooLong,
+    /// A compression pointer does not point backwards or there are too many of them
+    InvalidPointer,
+    /// The packet is larger than the 65535 bytes a DNS message can address
+    PacketTooLarge
+};
+
+/// Number of values in ParseError, for per-reason counters
+constexpr int ParseErrorCount = 8;
+
 /**
  * @brief Parse a name from a raw DNS packet
  * @param packet raw DNS packet data
  * @param offset offset into the packet where the name begins
- * @param name reference to QByteArray to store the name in
+ * @param name reference to QByteArray to append the name to, in escaped dotted form
  * @return true if no errors occurred
  *
  * The offset will be incremented by the number of bytes read. Name
  * compression requires access to the contents of the packet.
+ *
+ * The work done for a name is bounded whatever the packet holds: names longer
+ * than 255 bytes or 128 labels are rejected, and compression pointers must
+ * point backwards, at most 128 times per name. Bytes past offset 65535 cannot
+ * be addressed and are treated as missing.
  */
 QTMDNS_EXPORT bool parseName(const QByteArray &packet, quint16 &offset, QByteArray &name);
 
+/**
+ * @brief Parse a name from a raw DNS packet, keeping its labels as they are
+ * @param packet raw DNS packet data
+ * @param offset offset into the packet where the name begins
+ * @param name storage for the name
+ * @return true if no errors occurred
+ */
+QTMDNS_EXPORT bool parseName(const QByteArray &packet, quint16 &offset, DomainName &name);
+
 /**
  * @brief Write a name to a raw DNS packet
  * @param packet raw DNS packet to write to
@@ -48,9 +93,11 @@ QTMDNS_EXPORT bool parseName(const QByteArray &packet, quint16 &offset, QByteArr
  *
  * The offset will be incremented by the number of bytes read. The name map
  * will be updated with offsets of any names written so that it can be passed
- * to future invocations of this function.
+ * to future invocations of this function. It is indexed by the wire format
+ * of the names.
  */
 QTMDNS_EXPORT void writeName(QByteArray &packet, quint16 &offset, const QByteArray &name, QMap<QByteArray, quint16> &nameMap);
+QTMDNS_EXPORT void writeName(QByteArray &packet, quint16 &offset, const DomainName &name, QMap<QByteArray, quint16> &nameMap);
 
 /**
  * @brief Parse a record from a raw DNS packet
@@ -70,6 +117,15 @@ QTMDNS_EXPORT bool parseRecord(const QByteArray &packet, quint16 &offset, Record
  */
 QTMDNS_EXPORT void writeRecord(QByteArray &packet, quint16 &offset, const Record& record, QMap<QByteArray, quint16> &nameMap);
 
+/**
+ * @brief Retrieve the data of a record in uncompressed wire format
+ * @param record record to encode
+ * @return the rdata, without its length
+ *
+ * This is the form records are compared in when probes tie (RFC 6762 §8.2).
+ */
+QTMDNS_EXPORT QByteArray rdataToWireFormat(const Record &record);
+
 /**
  * @brief Populate a Message with data from a raw DNS packet
  * @param packet raw DNS packet data
@@ -78,6 +134,15 @@ QTMDNS_EXPORT void writeRecord(QByteArray &packet, quint16 &offset, const Record
  */
 QTMDNS_EXPORT bool fromPacket(const QByteArray &packet, Message &message);
 
+/**
+ * @brief Populate a Message with data from a raw DNS packet
+ * @param packet raw DNS packet data
+ * @param message reference to Message to populate
+ * @param error set to the reason the packet was rejected, if any
+ * @return true if no errors occurred
+ */
+QTMDNS_EXPORT bool fromPacket(const QByteArray &packet, Message &message, ParseError &error);
+
 /**
  * @brief Create a raw DNS packet from a Message
  * @param message Message to create the packet from
@@ -85,6 +150,31 @@ QTMDNS_EXPORT bool fromPacket(const QByteArray &packet, Message &message);
  */
 QTMDNS_EXPORT QByteArray toPacket(const Message &message);
 
+/**
+ * @brief Split a Message into messages that each fit in a packet
+ * @param message Message to split
+ * @param maxSize largest packet size, such as MdnsMaxPacketSize
+ * @return the messages, with the address, port and flags of the original
+ *
+ * Queries and records keep their order and their section. A query stays in
+ * the same message as the authority records of its name, which a probe
+ * proposes for tiebreaking. A query or record too large for a packet of its
+ * own is sent alone.
+ */
+QTMDNS_EXPORT QList<Message> splitMessage(const Message &message, quint16 maxSize);
+
+/**
+ * @brief Create a NSEC record listing the types of records that exist for a name
+ * @param name name the record is about
+ * @param types types of the records that exist, below 256
+ * @param ttl TTL of the record, which should be the one of those records
+ *
+ * Responders send such records to assert that no other type exists for the
+ * name (RFC 6762 §6.1): as the answer to a query for a missing type, or in
+ * the additional section.
+ */
+QTMDNS_EXPORT Record nsecRecord(const DomainName &name, const QList<quint16> &types, quint32 ttl);
+
 /**
  * @brief Retrieve the string representation of a DNS type
  * @param type integer type
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "qtmdns_export.hpp"
+
+#include <QByteArray>
+#include <QList>
+
+#include <cstddef>
+
+namespace QtMdns {
+
+struct DomainNameData;
+
+/**
+ * @brief Interned, case-insensitive domain name
+ *
+ * Domain names are kept as a sequence of labels, in DNS wire format, and
+ * stored once in a process-wide table: every DomainName with the same labels
+ * shares the same data, whatever the number of records using it. Each name
+ * also references its parent (the name without its first label), so the
+ * suffixes of a name are interned too and suffix checks follow that chain
+ * instead of comparing strings.
+ *
+ * Comparisons follow RFC 6762 §16: ASCII letters are compared without regard
+ * to case, other bytes must match exactly. As names differing only by case
+ * share the same folded entry, equality is a pointer comparison. The
+ * original spelling is kept for display:
+ *
+ * @code
+ * QtMdns::DomainName const a("My Printer._ipp._tcp.local.");
+ * QtMdns::DomainName const b("my printer._IPP._tcp.local.");
+ * Q_ASSERT(a == b);
+ * qDebug() << a.label(0);  // "My Printer"
+ * @endcode
+ *
+ * Labels may contain any byte, including dots. In the dotted form, a dot or
+ * a backslash that is part of a label is escaped with a backslash, as in
+ * "Living Room v2\.1._http._tcp.local.".
+ *
+ * All methods are thread-safe.
+ */
+class QTMDNS_EXPORT DomainName
+{
+public:
+    /**
+     * @brief Create a null name
+     */
+    DomainName() = default;
+
+    /**
+     * @brief Intern a name in dotted form, such as "host.local."
+     *
+     * Backslash escapes ("\." and "\\", or a decimal "\DDD") are decoded. The
+     * name is null if it is not valid: an empty label, a label longer than
+     * 63 bytes or a name longer than 255 bytes in wire format.
+     */
+    explicit DomainName(QByteArray const& name);
+
+    DomainName(DomainName const& other);
+    DomainName(DomainName&& other) noexcept;
+    DomainName& operator=(DomainName const& other);
+    DomainName& operator=(DomainName&& other) noexcept;
+    ~DomainName();
+
+    /**
+     * @brief Create a name from its labels, leftmost first
+     * @return the name, or a null name if a label is empty or too long
+     */
+    static DomainName fromLabels(QList<QByteArray> const& labels);
+
+    /**
+     * @brief Create a name from its uncompressed wire format
+     * @return the name, or a null name if the wire format is not valid
+     */
+    static DomainName fromWireFormat(QByteArray const& wire);
+
+    /**
+     * @brief Names are equal if they only differ by the case of ASCII letters
+     */
+    bool operator==(DomainName const& other) const;
+    bool operator!=(DomainName const& other) const;
+
+    /**
+     * @brief Determine if the name is null
+     */
+    bool isNull() const;
+
+    /**
+     * @brief Determine if the name is the root, which has no label
+     */
+    bool isRoot() const;
+
+    /**
+     * @brief Retrieve the name in escaped dotted form, as originally spelled
+     *
+     * The dotted form always ends with the root dot.
+     */
+    QByteArray toByteArray() const;
+
+    /**
+     * @brief Retrieve the name in uncompressed wire format
+     */
+    QByteArray toWireFormat() const;
+
+    /**
+     * @brief Retrieve the case-insensitive hash of the name
+     */
+    size_t hash() const;
+
+    /**
+     * @brief Retrieve the number of labels, not counting the root
+     */
+    int labelCount() const;
+
+    /**
+     * @brief Retrieve a label, unescaped
+     * @param index index of the label, 0 being the leftmost one
+     */
+    QByteArray label(int index) const;
+
+    /**
+     * @brief Retrieve all the labels, leftmost first
+     */
+    QList<QByteArray> labels() const;
+
+    /**
+     * @brief Retrieve the name without its leftmost label
+     *
+     * The parent of the root, or of a null name, is null.
+     */
+    DomainName parent() const;
+
+    /**
+     * @brief Retrieve the name with a label prepended
+     * @return the name, or a null name if the result would not be valid
+     */
+    DomainName child(QByteArray const& label) const;
+
+    /**
+     * @brief Determine if the name is the same as suffix or one of its subdomains
+     *
+     * Whole labels are compared, so "foo.local." does not end with "oo.local.".
+     */
+    bool endsWith(DomainName const& suffix) const;
+
+    /**
+     * @brief Retrieve the number of names currently interned, suffixes included
+     */
+    static qsizetype internedCount();
+
+private:
+    // Adopts a reference to data
+    explicit DomainName(DomainNameData* data);
+
+    DomainNameData* d {nullptr};
+};
+
+/**
+ * @brief Case-insensitive hash of a name, for use in QHash and QSet
+ */
+QTMDNS_EXPORT size_t qHash(DomainName const& name, size_t seed = 0);
+
+} // namespace QtMdns
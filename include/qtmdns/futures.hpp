@@ -0,0 +1,87 @@
+#pragma once
+
+#include "qtmdns_export.hpp"
+
+#include <qtmdns/resolver.hpp>
+#include <qtmdns/service.hpp>
+
+#include <QtGlobal>
+
+#if(QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+
+#include <QByteArray>
+#include <QFuture>
+#include <QList>
+
+#include <memory>
+
+namespace QtMdns {
+
+class AbstractServer;
+class Cache;
+class Record;
+
+/**
+ * @file
+ * @brief Future-based discovery
+ *
+ * These functions start an operation and return a future of its result, so
+ * that discovery steps can be chained with QFuture::then() instead of
+ * spreading a state machine over slots:
+ *
+ * @code
+ * QtMdns::browseAsync(&server, "_http._tcp.local.", 1, 2000)
+ *     .then([&server](const QList<QtMdns::Service> &services) {
+ *         QList<QByteArray> hostnames;
+ *         for (const QtMdns::Service &service : services)
+ *             hostnames.append(service.hostname());
+ *         return QtMdns::resolveAsync(&server, hostnames, 2000);
+ *     })
+ *     .unwrap()
+ *     .then([](const QtMdns::ResolveResult &result) {
+ *         qDebug() << result.addresses;
+ *     });
+ * @endcode
+ *
+ * Results are reported from the event loop of the thread of the server.
+ * Futures of operations still running when the server is destroyed are
+ * canceled. They require Qt 6.
+ */
+
+/**
+ * @brief Browse for services of a type until enough are found
+ * @param server server to use for receiving and sending mDNS messages
+ * @param type service type to browse for
+ * @param count number of services to wait for, or 0 to wait until the timeout
+ * @param timeout delay in milliseconds after which the services found so far are reported
+ * @param cache DNS cache to use or null to create one
+ *
+ * Canceling the future stops browsing with the next service found.
+ */
+QTMDNS_EXPORT QFuture<QList<Service>> browseAsync(AbstractServer* server, const QByteArray &type, int count,
+                                                  int timeout, std::shared_ptr<Cache> cache = nullptr);
+
+/**
+ * @brief Resolve hostnames with a deadline
+ *
+ * This is Resolver::resolve() with its result reported through a future,
+ * and shares its scheduling: questions of all the resolutions of the server
+ * are sent together and no object is created for each of them.
+ */
+QTMDNS_EXPORT QFuture<ResolveResult> resolveAsync(AbstractServer* server, const QList<QByteArray> &names,
+                                                  int timeout, std::shared_ptr<Cache> cache = nullptr);
+
+/**
+ * @brief Probe for a unique name
+ * @param server server to use for receiving and sending mDNS messages
+ * @param record record to confirm, see Prober
+ *
+ * The future reports the name once it is confirmed, after a rename if the
+ * name of the record was taken. The probes share the schedule of all the
+ * other probes of the server.
+ */
+QTMDNS_EXPORT QFuture<QByteArray> probeAsync(AbstractServer* server, const Record &record);
+
+} // namespace QtMdns
+
+#endif
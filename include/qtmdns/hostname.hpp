@@ -2,12 +2,15 @@
 
 #include "qtmdns_export.hpp"
 
+#include <QHostAddress>
+#include <QList>
 #include <QObject>
 #include <QScopedPointer>
 
 namespace QtMdns {
 
 class AbstractServer;
+class Record;
 
 class QTMDNS_EXPORT HostnamePrivate;
 
@@ -51,6 +54,16 @@ public:
      */
     QByteArray hostname() const;
 
+    /**
+     * @brief Retrieve the address records of the hostname for a peer
+     * @param peer address of the peer the records are sent to
+     *
+     * The addresses are those of the interface the peer is reachable on, at
+     * most one A and one AAAA record. Responders add them to the additional
+     * section of answers pointing to the hostname.
+     */
+    QList<Record> addressRecords(const QHostAddress &peer) const;
+
 Q_SIGNALS:
 
     /**
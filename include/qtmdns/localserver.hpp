@@ -0,0 +1,152 @@
+#pragma once
+
+#include "qtmdns_export.hpp"
+
+#include <qtmdns/abstractserver.hpp>
+
+#include <QHostAddress>
+#include <QObject>
+#include <QScopedPointer>
+
+namespace QtMdns {
+
+class LocalServer;
+class Message;
+
+class QTMDNS_EXPORT LocalNetworkPrivate;
+class QTMDNS_EXPORT LocalServerPrivate;
+
+/**
+ * @brief Simulated network segment for in-process servers
+ *
+ * A local network connects any number of [LocalServer](@ref QtMdns::LocalServer)
+ * instances as if they were hosts on the same link. Messages are encoded with
+ * toPacket() and decoded again by every receiver with fromPacket(), so the
+ * full wire path is exercised without any socket.
+ *
+ * Multicast messages are delivered to every attached server, including the
+ * sender (like a socket with multicast loopback enabled). Delivery is always
+ * asynchronous and happens after the configured latency.
+ *
+ * This is meant for scenario benchmarks and simulations, for example to
+ * measure how long a [Browser](@ref QtMdns::Browser) takes to discover many
+ * providers and how many packets are exchanged meanwhile:
+ *
+ * @code
+ * QtMdns::LocalNetwork network;
+ * network.setLatency(1);
+ *
+ * QtMdns::LocalServer server1(&network, QHostAddress("10.0.0.1"));
+ * QtMdns::LocalServer server2(&network, QHostAddress("10.0.0.2"));
+ * @endcode
+ */
+class QTMDNS_EXPORT LocalNetwork : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalNetwork(QObject* parent = nullptr);
+    ~LocalNetwork() override;
+
+    /**
+     * @brief Retrieve the one-way delivery latency in milliseconds
+     */
+    int latency() const;
+
+    /**
+     * @brief Set the one-way delivery latency in milliseconds
+     *
+     * The default is 0, which still delivers on the next event loop
+     * iteration.
+     */
+    void setLatency(int msecs);
+
+    /**
+     * @brief Retrieve the number of packets sent on the network
+     *
+     * A multicast message counts as a single packet, regardless of the number
+     * of receivers.
+     */
+    quint64 packetsSent() const;
+
+    /**
+     * @brief Retrieve the number of bytes sent on the network
+     */
+    quint64 bytesSent() const;
+
+    /**
+     * @brief Retrieve the number of packets delivered to servers
+     */
+    quint64 packetsDelivered() const;
+
+    /**
+     * @brief Reset all packet and byte counters to zero
+     */
+    void resetCounters();
+
+Q_SIGNALS:
+
+    /**
+     * @brief Indicate that a packet was put on the network
+     * @param sender server that sent the packet
+     * @param packet raw DNS packet
+     */
+    void packetSent(QtMdns::LocalServer* sender, QByteArray const& packet);
+
+private:
+    friend class LocalServer;
+
+    Q_DECLARE_PRIVATE_D(dd_ptr, LocalNetwork)
+    QScopedPointer<LocalNetworkPrivate> dd_ptr;
+};
+
+/**
+ * @brief Server attached to a simulated network
+ *
+ * This class provides an implementation of
+ * [AbstractServer](@ref QtMdns::AbstractServer) that exchanges messages
+ * with other servers of the same [LocalNetwork](@ref QtMdns::LocalNetwork).
+ * The address identifies the server on the network: it is the source address
+ * of the messages it sends and the destination of unicast replies.
+ */
+class QTMDNS_EXPORT LocalServer : public AbstractServer
+{
+    Q_OBJECT
+public:
+    LocalServer(LocalNetwork* network, QHostAddress address, QObject* parent = nullptr);
+    ~LocalServer() override;
+
+    /**
+     * @brief Retrieve the address of the server on the network
+     */
+    QHostAddress address() const;
+
+    /**
+     * @brief Retrieve the number of packets sent by this server
+     */
+    quint64 packetsSent() const;
+
+    /**
+     * @brief Retrieve the number of packets received by this server
+     */
+    quint64 packetsReceived() const;
+
+    void sendMessage(Message const& message) override;
+    void sendMessageToAll(Message const& message) override;
+
+    /**
+     * @brief Inject a raw packet as if it was received from the network
+     * @param packet raw DNS packet
+     * @param address source address of the packet
+     * @param port source port of the packet
+     * @return true if the packet was decoded and dispatched
+     */
+    bool receivePacket(QByteArray const& packet, QHostAddress const& address, quint16 port);
+
+private:
+    void send(Message const& message, QHostAddress const& destination);
+
+    Q_DECLARE_PRIVATE_D(dd_ptr, LocalServer)
+    QScopedPointer<LocalServerPrivate> dd_ptr;
+};
+
+} // namespace QtMdns
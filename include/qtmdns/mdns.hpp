@@ -13,6 +13,7 @@ struct Defaults
     QHostAddress const MdnsIpv4Address; //! Standard IPv4 address for mDNS
     QHostAddress const MdnsIpv6Address; //! Standard IPv6 address for mDNS
     QByteArray const MdnsBrowseType; //! Service type for browsing service types
+    quint16 const MdnsMaxPacketSize; //! Largest message sent unsolicited: an Ethernet frame less the IPv6 and UDP headers
 };
 
 Defaults const& mdnsDefaults();
@@ -17,7 +17,10 @@ class QTMDNS_EXPORT MessagePrivate;
  * @brief DNS message
  *
  * A DNS message consists of a header and zero or more queries and records.
- * Instances of this class are created and initialized by
+ * Records belong to one of three sections: answers, authority records (the
+ * records proposed in probes) and additional records, which the receiver did
+ * not ask for but will likely need, such as the addresses of the target of
+ * an answered SRV record. Instances of this class are created and initialized by
  * [AbstractServer](@ref QtMdns::AbstractServer) when messages are
  * received from the network.
  *
@@ -35,9 +38,20 @@ class QTMDNS_EXPORT MessagePrivate;
 class QTMDNS_EXPORT Message
 {
 public:
+    /**
+     * @brief Section of a record in the message
+     */
+    enum Section : quint8 {
+        Answer,
+        Authority,
+        Additional
+    };
+
     Message();
     Message(const Message &other);
+    Message(Message &&other);
     Message& operator=(const Message &other);
+    Message& operator=(Message &&other) noexcept;
     ~Message();
 
     /**
@@ -120,17 +134,32 @@ public:
      * @brief Add a query to the message
      */
     void addQuery(Query const& query);
+    void addQuery(Query&& query);
     void addQueries(QList<Query> const& query);
 
     /**
      * @brief Retrieve a list of records in the message
+     *
+     * Records of all sections are retrieved: answers first, then authority
+     * and additional records.
      */
     QList<Record> records() const;
 
     /**
-     * @brief Add a record to the message
+     * @brief Retrieve the records of a section of the message
+     */
+    QList<Record> records(Section section) const;
+
+    /**
+     * @brief Add a record to a section of the message
+     */
+    void addRecord(const Record &record, Section section = Answer);
+    void addRecord(Record &&record, Section section = Answer);
+
+    /**
+     * @brief Reserve storage for the given number of queries and records
      */
-    void addRecord(const Record &record);
+    void reserve(qsizetype queries, qsizetype records);
 
     /**
      * @brief Reply to another message
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "qtmdns_export.hpp"
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QScopedPointer>
+
+class QIODevice;
+
+namespace QtMdns {
+
+class LocalServer;
+
+class QTMDNS_EXPORT PacketTracePrivate;
+
+/**
+ * @brief Raw datagram recorded by a [PacketTrace](@ref QtMdns::PacketTrace)
+ */
+struct QTMDNS_EXPORT TracedPacket
+{
+    enum Direction : quint8 {
+        Received = 0,
+        Sent = 1
+    };
+
+    qint64 timestamp {0};       //! Microseconds since the Unix epoch
+    Direction direction {Received};
+    int interfaceIndex {0};     //! Index of the interface, 0 if unknown
+    QHostAddress address;       //! Source when received, destination when sent
+    quint16 port {0};           //! Source port when received, destination port when sent
+    QByteArray data;            //! Raw DNS packet
+};
+
+/**
+ * @brief Ring buffer of raw mDNS datagrams
+ *
+ * A trace can be attached to a server with
+ * [AbstractServer::setPacketTrace()](@ref QtMdns::AbstractServer::setPacketTrace)
+ * to record every datagram sent and received, with its timestamp, interface
+ * and direction. Once the buffer is full, the oldest packets are dropped.
+ * When no trace is attached, the server does not copy anything.
+ *
+ * The content can be saved as pcapng (readable by Wireshark, IP and UDP
+ * headers are synthesized) or as a compact binary log, and read back to
+ * replay it offline:
+ *
+ * @code
+ * auto trace = std::make_shared<QtMdns::PacketTrace>(4096);
+ * server.setPacketTrace(trace);
+ *
+ * // Later, when something looks wrong
+ * QFile file("mdns.pcapng");
+ * if (file.open(QIODevice::WriteOnly))
+ *     trace->writePcapng(&file);
+ * @endcode
+ *
+ * All methods are thread-safe.
+ */
+class QTMDNS_EXPORT PacketTrace
+{
+public:
+    explicit PacketTrace(int capacity = 1024);
+    ~PacketTrace();
+
+    PacketTrace(PacketTrace const&) = delete;
+    PacketTrace& operator=(PacketTrace const&) = delete;
+
+    /**
+     * @brief Retrieve the maximum number of packets kept
+     */
+    int capacity() const;
+
+    /**
+     * @brief Set the maximum number of packets kept
+     *
+     * If the trace holds more packets, the oldest ones are dropped.
+     */
+    void setCapacity(int capacity);
+
+    /**
+     * @brief Retrieve the number of packets currently held
+     */
+    int count() const;
+
+    /**
+     * @brief Retrieve the number of packets dropped since the last clear()
+     */
+    quint64 dropped() const;
+
+    /**
+     * @brief Add a packet, dropping the oldest one if the trace is full
+     */
+    void add(TracedPacket packet);
+
+    /**
+     * @brief Retrieve the packets held, oldest first
+     */
+    QList<TracedPacket> packets() const;
+
+    /**
+     * @brief Remove all packets
+     */
+    void clear();
+
+    /**
+     * @brief Write the packets held as a pcapng capture
+     * @return true if the whole capture was written
+     */
+    bool writePcapng(QIODevice* device) const;
+
+    /**
+     * @brief Write the packets held as a compact binary log
+     * @return true if the whole log was written
+     */
+    bool writeLog(QIODevice* device) const;
+
+    /**
+     * @brief Read packets from a pcapng capture
+     * @param device device to read from
+     * @param packets storage for the packets read
+     * @return true if the capture was valid
+     *
+     * Only UDP datagrams on the mDNS port are kept. Raw IP, Ethernet and
+     * Linux cooked link types are supported.
+     */
+    static bool readPcapng(QIODevice* device, QList<TracedPacket>& packets);
+
+    /**
+     * @brief Read packets from a classic (libpcap) capture
+     * @param device device to read from
+     * @param packets storage for the packets read
+     * @return true if the capture was valid
+     *
+     * Both microsecond and nanosecond captures, in either byte order, are
+     * supported. Only UDP datagrams on the mDNS port are kept.
+     */
+    static bool readPcap(QIODevice* device, QList<TracedPacket>& packets);
+
+    /**
+     * @brief Read packets from a pcap, pcapng or binary log file
+     * @param device device to read from
+     * @param packets storage for the packets read
+     * @return true if the format was recognized and the file was valid
+     */
+    static bool readCapture(QIODevice* device, QList<TracedPacket>& packets);
+
+    /**
+     * @brief Read packets from a binary log written by writeLog()
+     * @param device device to read from
+     * @param packets storage for the packets read
+     * @return true if the log was valid
+     */
+    static bool readLog(QIODevice* device, QList<TracedPacket>& packets);
+
+    /**
+     * @brief Feed received packets to a server
+     * @param packets packets to replay, in order
+     * @param server stand-in server that decodes and dispatches them
+     * @return number of packets that were decoded successfully
+     *
+     * Packets are injected as fast as possible, sent packets are skipped.
+     */
+    static int replay(QList<TracedPacket> const& packets, LocalServer& server);
+
+private:
+    Q_DECLARE_PRIVATE_D(dd_ptr, PacketTrace)
+    QScopedPointer<PacketTracePrivate> dd_ptr;
+};
+
+} // namespace QtMdns
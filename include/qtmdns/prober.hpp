@@ -19,6 +19,13 @@ class QTMDNS_EXPORT ProberPrivate;
  * must be confirmed. This class takes care of probing for existing records
  * that match and adjusts the record's name until a unique one is found.
  *
+ * Probing follows RFC 6762 §8: three probes are sent 250 ms apart, so a name
+ * is confirmed about 750 ms after the prober is created. All the probers of
+ * a server share the same schedule and their probes are sent together, in as
+ * few messages as fit in a packet. When another host probes the same name at the same time,
+ * the lexicographically later set of records wins and the other host waits
+ * one second before probing again.
+ *
  * For example, to probe for a SRV record:
  *
  * @code
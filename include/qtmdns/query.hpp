@@ -5,6 +5,8 @@
 #include <QByteArray>
 #include <QScopedPointer>
 
+#include <qtmdns/domainname.hpp>
+
 namespace QtMdns {
 
 class QTMDNS_EXPORT QueryPrivate;
@@ -28,7 +30,9 @@ class QTMDNS_EXPORT Query
 public:
     Query();
     Query(const Query &other);
+    Query(Query &&other);
     Query& operator=(const Query &other);
+    Query& operator=(Query &&other) noexcept;
     ~Query();
 
     /**
@@ -36,10 +40,16 @@ public:
      */
     QByteArray name() const;
 
+    /**
+     * @brief Retrieve the name being queried, for case-insensitive comparisons
+     */
+    DomainName const& domainName() const;
+
     /**
      * @brief Set the name to query
      */
     void setName(const QByteArray &name);
+    void setName(DomainName const& name);
 
     /**
      * @brief Retrieve the type of record being queried
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "qtmdns_export.hpp"
+
+#include <qtmdns/bitmap.hpp>
+#include <qtmdns/domainname.hpp>
+#include <qtmdns/txtdata.hpp>
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QMap>
+
+#include <cstring>
+#include <variant>
+
+namespace QtMdns {
+
+/**
+ * @brief Data of QtMdns::A and QtMdns::AAAA records
+ */
+struct QTMDNS_EXPORT AddressRdata
+{
+    QHostAddress address;
+
+    bool operator==(AddressRdata const& other) const { return address == other.address; }
+};
+
+/**
+ * @brief Data of QtMdns::PTR, QtMdns::CNAME and QtMdns::NS records
+ */
+struct QTMDNS_EXPORT PtrRdata
+{
+    DomainName target;
+
+    bool operator==(PtrRdata const& other) const { return target == other.target; }
+};
+
+/**
+ * @brief Data of QtMdns::SRV records
+ */
+struct QTMDNS_EXPORT SrvRdata
+{
+    quint16 priority {0};
+    quint16 weight {0};
+    quint16 port {0};
+    DomainName target;
+
+    bool operator==(SrvRdata const& other) const
+    {
+        return priority == other.priority && weight == other.weight
+            && port == other.port && target == other.target;
+    }
+};
+
+/**
+ * @brief Data of QtMdns::TXT records
+ */
+struct QTMDNS_EXPORT TxtRdata
+{
+    TxtData txt;
+
+    bool operator==(TxtRdata const& other) const { return txt == other.txt; }
+};
+
+/**
+ * @brief Data of QtMdns::NSEC records
+ */
+struct QTMDNS_EXPORT NsecRdata
+{
+    DomainName nextDomainName;
+    Bitmap bitmap;
+
+    bool operator==(NsecRdata const& other) const
+    {
+        return nextDomainName == other.nextDomainName && bitmap == other.bitmap;
+    }
+};
+
+/**
+ * @brief Data of records of a type the library does not decode
+ *
+ * The data is kept exactly as received, as a slice of the packet the record
+ * was decoded from: the packet buffer is shared rather than copied, and the
+ * data is written back byte for byte. This lets caches and proxies carry
+ * records of any type, such as HINFO or application-specific types.
+ *
+ * Names in the data are not decoded. Types that predate RFC 3597 and may use
+ * name compression in their data (SOA, MX and a few obsolete ones) only
+ * survive re-encoding if their names are not compressed.
+ */
+struct QTMDNS_EXPORT RawRdata
+{
+    QByteArray packet;   //! Buffer holding the data, usually the whole received packet
+    quint16 offset {0};  //! Offset of the data in packet
+    quint16 length {0};  //! Length of the data
+
+    /**
+     * @brief Create raw data owning its own buffer
+     */
+    static RawRdata fromByteArray(QByteArray const& data)
+    {
+        return RawRdata {data, 0, static_cast<quint16>(qMin<qsizetype>(data.size(), 0xffff))};
+    }
+
+    /**
+     * @brief Retrieve a pointer to the first byte of the data
+     */
+    char const* constData() const { return packet.constData() + offset; }
+
+    /**
+     * @brief Copy the data to a buffer of its own
+     */
+    QByteArray toByteArray() const { return QByteArray(constData(), length); }
+
+    bool operator==(RawRdata const& other) const
+    {
+        return length == other.length && std::memcmp(constData(), other.constData(), length) == 0;
+    }
+};
+
+/**
+ * @brief Type-specific data of a [Record](@ref QtMdns::Record)
+ *
+ * A record only stores the fields of its own type. std::monostate is used
+ * until a field is set.
+ */
+using Rdata = std::variant<std::monostate, AddressRdata, PtrRdata, SrvRdata, TxtRdata, NsecRdata, RawRdata>;
+
+} // namespace QtMdns
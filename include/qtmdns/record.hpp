@@ -8,6 +8,8 @@
 #include <QScopedPointer>
 
 #include <qtmdns/bitmap.hpp>
+#include <qtmdns/domainname.hpp>
+#include <qtmdns/rdata.hpp>
 
 namespace QtMdns {
 
@@ -17,7 +19,8 @@ class QTMDNS_EXPORT RecordPrivate;
  * @brief DNS record
  *
  * This class maintains information for an individual record. Not all record
- * types use every field.
+ * types use every field. The data of types without dedicated fields is kept
+ * as received, see [RawRdata](@ref QtMdns::RawRdata).
  *
  * For example, to create a TXT record:
  *
@@ -36,7 +39,9 @@ class QTMDNS_EXPORT Record
 public:
     Record();
     Record(const Record &other);
+    Record(Record &&other);
     Record &operator=(const Record &other);
+    Record &operator=(Record &&other) noexcept;
     ~Record();
 
     bool operator==(const Record &other) const;
@@ -47,10 +52,18 @@ public:
      */
     QByteArray name() const;
 
+    /**
+     * @brief Retrieve the name of the record, for case-insensitive comparisons
+     */
+    DomainName const& domainName() const;
+
     /**
      * @brief Set the name of the record
+     *
+     * The name is in escaped dotted form, see [DomainName](@ref QtMdns::DomainName).
      */
     void setName(const QByteArray &name);
+    void setName(DomainName const& name);
 
     /**
      * @brief Retrieve the type of the record
@@ -88,6 +101,34 @@ public:
      */
     void setTtl(quint32 ttl);
 
+    /**
+     * @brief Retrieve the type-specific data of the record
+     *
+     * The field accessors below read and write this data: setting a field of
+     * another kind of record replaces it.
+     */
+    Rdata const& rdata() const;
+
+    /**
+     * @brief Set the type-specific data of the record
+     */
+    void setRdata(Rdata rdata);
+
+    /**
+     * @brief Retrieve the type-specific data if it is of the given kind
+     * @return a pointer to the data, or null if the record holds another kind
+     *
+     * @code
+     * if (auto srv = record.rdataAs<QtMdns::SrvRdata>())
+     *     qDebug() << srv->target.toByteArray() << srv->port;
+     * @endcode
+     */
+    template<class T>
+    T const* rdataAs() const
+    {
+        return std::get_if<T>(&rdata());
+    }
+
     /**
      * @brief Retrieve the address for the record
      *
@@ -103,14 +144,21 @@ public:
     /**
      * @brief Retrieve the target for the record
      *
-     * This field is used by QtMdns::PTR and QtMdns::SRV records.
+     * This field is used by QtMdns::PTR, QtMdns::SRV, QtMdns::CNAME and
+     * QtMdns::NS records.
      */
     QByteArray target() const;
 
+    /**
+     * @brief Retrieve the target of the record, for case-insensitive comparisons
+     */
+    DomainName const& targetName() const;
+
     /**
      * @brief Set the target for the record
      */
     void setTarget(const QByteArray &target);
+    void setTarget(DomainName const& target);
 
     /**
      * @brief Retrieve the next domain name
@@ -169,7 +217,8 @@ public:
     /**
      * @brief Retrieve attributes for the record
      *
-     * This field is used by QtMdns::TXT records.
+     * This field is used by QtMdns::TXT records. Only the first entry of
+     * each key is kept, keys being compared without regard to case.
      */
     QMap<QByteArray, QByteArray> attributes() const;
 
@@ -180,9 +229,25 @@ public:
 
     /**
      * @brief Add an attribute to the record
+     *
+     * Entries with the same key are replaced. A null value adds a boolean
+     * attribute.
      */
     void addAttribute(const QByteArray &key, const QByteArray &value);
 
+    /**
+     * @brief Retrieve the TXT data of the record, as received
+     *
+     * This field is used by QtMdns::TXT records. Unlike attributes(), it
+     * keeps every entry in order, duplicate keys included.
+     */
+    TxtData txt() const;
+
+    /**
+     * @brief Set the TXT data of the record
+     */
+    void setTxt(TxtData const& txt);
+
     /**
      * @brief Retrieve the bitmap for the record
      *
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "qtmdns_export.hpp"
+
+#include <qtmdns/packettrace.hpp>
+#include <qtmdns/statistics.hpp>
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QScopedPointer>
+
+#include <functional>
+#include <memory>
+
+namespace QtMdns {
+
+class Browser;
+class Cache;
+class LocalServer;
+
+class QTMDNS_EXPORT ReplayerPrivate;
+
+/**
+ * @brief Result of a [Replayer](@ref QtMdns::Replayer) run
+ */
+struct QTMDNS_EXPORT ReplayStatistics
+{
+    quint64 packets {0};        //! Received packets injected
+    quint64 bytes {0};          //! Bytes injected
+    quint64 messages {0};       //! Packets decoded successfully
+    quint64 parseFailures {0};  //! Packets rejected by the decoder
+    quint64 records {0};        //! Records in the decoded messages
+
+    qint64 captureDuration {0}; //! Microseconds between the first and last packet of the capture
+    qint64 elapsed {0};         //! Nanoseconds spent replaying
+    double messagesPerSecond {0};
+
+    //! Allocations during the run, 0 without an allocation counter
+    quint64 allocations {0};
+
+    CacheStatistics cache;       //! Cache counters at the end of the run
+    BrowserStatistics browsers;  //! Sum of the counters of all browsers at the end of the run
+};
+
+/**
+ * @brief Offline harness feeding captured packets through the decode and browse stack
+ *
+ * A replayer owns a [LocalServer](@ref QtMdns::LocalServer) that is not
+ * attached to any network, a shared [Cache](@ref QtMdns::Cache) and any
+ * number of [Browser](@ref QtMdns::Browser) instances using that cache.
+ * Received packets of a capture are injected as fast as possible, while the
+ * cache follows a virtual clock set to the capture timestamp of each packet:
+ * records expire and refresh queries trigger as they did when the capture
+ * was taken, however long the replay actually takes. Queries sent by the
+ * browsers are dropped.
+ *
+ * Only the work done for each packet is measured. The event loop does not
+ * run during replay(), so the timers of the browsers never fire: services
+ * are not resolved from the cache in batches, nor loaded from it when a
+ * browser starts, and no query is sent. Statistics of the browsers only
+ * reflect what the received packets produce directly.
+ *
+ * @code
+ * QList<QtMdns::TracedPacket> packets;
+ * QFile file("mdns.pcap");
+ * if (file.open(QIODevice::ReadOnly) && QtMdns::PacketTrace::readCapture(&file, packets)) {
+ *     QtMdns::Replayer replayer;
+ *     replayer.addBrowser(QtMdns::mdnsDefaults().MdnsBrowseType);
+ *     QtMdns::ReplayStatistics const stats = replayer.replay(packets);
+ *     qDebug() << stats.messagesPerSecond << "messages/s";
+ * }
+ * @endcode
+ *
+ * The library does not hook the global allocator. To report allocation
+ * counts, the application replaces operator new with a counting one and
+ * gives a function returning the current count to setAllocationCounter().
+ */
+class QTMDNS_EXPORT Replayer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Replayer(QObject* parent = nullptr);
+    ~Replayer() override;
+
+    /**
+     * @brief Retrieve the stand-in server packets are injected into
+     */
+    LocalServer* server() const;
+
+    /**
+     * @brief Retrieve the cache shared by the browsers
+     */
+    std::shared_ptr<Cache> cache() const;
+
+    /**
+     * @brief Add a browser for the given service type
+     * @param type service type, or the browse type to browse all services
+     * @return browser owned by the replayer
+     */
+    Browser* addBrowser(QByteArray const& type);
+
+    /**
+     * @brief Set the function used to count allocations
+     * @param counter function returning the number of allocations so far, or null
+     */
+    void setAllocationCounter(std::function<quint64()> counter);
+
+    /**
+     * @brief Replay the received packets of a capture
+     * @param packets packets to replay, in capture order; sent packets are skipped
+     * @return counters of the run
+     */
+    ReplayStatistics replay(QList<TracedPacket> const& packets);
+
+private:
+    Q_DECLARE_PRIVATE_D(dd_ptr, Replayer)
+    QScopedPointer<ReplayerPrivate> dd_ptr;
+};
+
+} // namespace QtMdns
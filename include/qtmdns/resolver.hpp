@@ -2,10 +2,15 @@
 
 #include "qtmdns_export.hpp"
 
+#include <QHash>
 #include <QHostAddress>
+#include <QList>
 #include <QObject>
 #include <QScopedPointer>
 
+#include <functional>
+#include <memory>
+
 namespace QtMdns {
 
 class AbstractServer;
@@ -13,6 +18,15 @@ class Cache;
 
 class QTMDNS_EXPORT ResolverPrivate;
 
+/**
+ * @brief Addresses found by Resolver::resolve()
+ */
+struct QTMDNS_EXPORT ResolveResult
+{
+    QHash<QByteArray, QList<QHostAddress>> addresses; //! Addresses of each name, empty for names not resolved
+    bool timedOut {false};                             //! The deadline passed before every name resolved
+};
+
 /**
  * @brief %Resolver for services
  *
@@ -29,6 +43,10 @@ class QTMDNS_EXPORT ResolverPrivate;
  *     qDebug() << "Address:" << address;
  * });
  * @endcode
+ *
+ * To resolve many hosts at once, resolve() does without any object: the
+ * questions for all the names are packed in as few messages as possible,
+ * and the callback is called once with every address found.
  */
 class QTMDNS_EXPORT Resolver : public QObject
 {
@@ -38,6 +56,30 @@ public:
     Resolver(AbstractServer* server, const QByteArray &name, QObject* parent = nullptr);
     ~Resolver() override;
 
+    /**
+     * @brief Resolve many hostnames at once
+     * @param server server to send the queries with
+     * @param names hostnames to resolve
+     * @param timeout delay in milliseconds after which the resolution ends
+     * @param callback function called with the addresses found
+     * @param cache cache to look the addresses up in and to add them to, or null
+     *
+     * Questions for the A and AAAA records of all the names are sent
+     * together, split in messages that fit an Ethernet frame, and those of
+     * resolutions started meanwhile join them. Questions left unanswered are
+     * sent again after 1 s, 2 s, 4 s and so on until the timeout.
+     *
+     * A name is resolved once both of its address families are answered,
+     * either with addresses or with a NSEC record stating that the host has
+     * none. Hosts that never answer for one family are given until the next
+     * retry. The callback is called once, from the event loop, when every
+     * name is resolved or the timeout expires; it is not called if the
+     * server is destroyed first.
+     */
+    static void resolve(AbstractServer* server, const QList<QByteArray> &names, int timeout,
+                        std::function<void(const ResolveResult&)> callback,
+                        std::shared_ptr<Cache> cache = nullptr);
+
 Q_SIGNALS:
     /**
      * @brief Indicate that the host resolved to an address
@@ -12,6 +12,40 @@ namespace QtMdns {
 
 class QTMDNS_EXPORT ServicePrivate;
 
+/**
+ * @brief Address of a host providing a service, from one of its A or AAAA records
+ */
+struct QTMDNS_EXPORT ServiceAddress
+{
+    QHostAddress address;  //! Link-local IPv6 addresses are scoped to the interface they were received on
+    QByteArray hostname;   //! Target the address belongs to
+    quint32 ttl {0};       //! TTL of the record, in seconds
+
+    // TTLs are not compared: a renewed address is the same address
+    bool operator==(ServiceAddress const& other) const
+    {
+        return address == other.address && address.scopeId() == other.address.scopeId()
+            && hostname == other.hostname;
+    }
+};
+
+/**
+ * @brief Host and port a service is reachable at, from one of its SRV records
+ */
+struct QTMDNS_EXPORT ServiceTarget
+{
+    QByteArray hostname;
+    quint16 port {0};
+    quint16 priority {0};  //! Targets with the lowest priority are used first
+    quint16 weight {0};    //! Relative share of the connections among targets of the same priority
+
+    bool operator==(ServiceTarget const& other) const
+    {
+        return hostname == other.hostname && port == other.port
+            && priority == other.priority && weight == other.weight;
+    }
+};
+
 /**
  * @brief %Service available on the local network
  *
@@ -21,6 +55,15 @@ class QTMDNS_EXPORT ServicePrivate;
  * discovered. Instances must be created and passed to
  * [Provider::update()](@ref QtMdns::Provider::update) to provide a
  * service.
+ *
+ * A service may be reachable at several targets, one for each of its SRV
+ * records, such as the hosts of a load-balanced service. hostname() and
+ * port() are those of the preferred target; clients spreading their
+ * connections should pick one with selectTarget() instead.
+ *
+ * Hosts may also have several addresses, on several interfaces or of several
+ * scopes, which addresses() lists. hostAddress() and hostAddressIPv6() are
+ * only the preferred address of each family.
  */
 class QTMDNS_EXPORT Service
 {
@@ -52,7 +95,8 @@ public:
      * @brief Set the service name
      *
      * This is combined with the service type and domain to form the FQDN for
-     * the service.
+     * the service. The name is a single label of at most 63 bytes: it is
+     * used as is, dots included.
      */
     void setName(const QByteArray &name);
 
@@ -69,12 +113,50 @@ public:
     quint16 port() const;
     void setPort(quint16 port);
 
+    /**
+     * @brief Retrieve the targets of the service
+     *
+     * Targets are ordered by priority, then by decreasing weight.
+     */
+    QList<ServiceTarget> targets() const;
+
+    /**
+     * @brief Set the targets of the service
+     *
+     * The hostname and port are set to those of the first target, which
+     * should be the preferred one.
+     */
+    void setTargets(const QList<ServiceTarget> &targets);
+
+    /**
+     * @brief Pick a target following RFC 2782
+     *
+     * A target of the lowest priority is picked at random, in proportion to
+     * its weight; targets with a weight of 0 have a small chance to be
+     * picked. Without targets, the hostname and port are returned.
+     */
+    ServiceTarget selectTarget() const;
+
     QHostAddress const& hostAddress() const;
     void setHostAddress(QHostAddress const& address);
 
     QHostAddress const& hostAddressIPv6() const;
     void setHostAddressIPv6(QHostAddress const& address);
 
+    /**
+     * @brief Retrieve every address of the targets of the service
+     */
+    QList<ServiceAddress> addresses() const;
+
+    /**
+     * @brief Set the addresses of the targets of the service
+     *
+     * The host addresses are set to the first address of each family; for
+     * IPv6, the first one that is not link-local if any, as link-local
+     * addresses are only reachable on the interface of their scope.
+     */
+    void setAddresses(const QList<ServiceAddress> &addresses);
+
     /**
      * @brief Retrieve the attributes for the service
      *
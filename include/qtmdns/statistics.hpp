@@ -0,0 +1,115 @@
+#pragma once
+
+#include "qtmdns_export.hpp"
+
+#include <qtmdns/dns.hpp>
+
+#include <QMap>
+#include <QMetaType>
+#include <QString>
+
+#include <array>
+
+namespace QtMdns {
+
+/**
+ * @brief Histogram of packet sizes
+ *
+ * Bucket i counts packets of at most Bounds[i] bytes (and more than the
+ * previous bound); the last bucket counts larger packets.
+ */
+struct QTMDNS_EXPORT PacketSizeHistogram
+{
+    static constexpr std::array<qsizetype, 6> Bounds {128, 256, 512, 1024, 1500, 9000};
+
+    std::array<quint64, Bounds.size() + 1> buckets {};
+
+    static int bucket(qsizetype size)
+    {
+        int i = 0;
+        while (i < static_cast<int>(Bounds.size()) && size > Bounds[i])
+            ++i;
+        return i;
+    }
+};
+
+/**
+ * @brief Traffic counters of a single network interface
+ */
+struct QTMDNS_EXPORT InterfaceStatistics
+{
+    QString name; //! Interface name, empty if unknown
+    quint64 packetsReceived {0};
+    quint64 packetsSent {0};
+    quint64 bytesReceived {0};
+    quint64 bytesSent {0};
+    quint64 sendFailures {0};
+};
+
+/**
+ * @brief Snapshot of the counters of an [AbstractServer](@ref QtMdns::AbstractServer)
+ *
+ * Message counters are incremented once per message, packet counters once per
+ * datagram: a message sent to all interfaces counts as one message and as
+ * one packet per interface and protocol.
+ */
+struct QTMDNS_EXPORT ServerStatistics
+{
+    quint64 packetsReceived {0};
+    quint64 packetsSent {0};
+    quint64 bytesReceived {0};
+    quint64 bytesSent {0};
+    quint64 sendFailures {0};
+
+    quint64 queriesReceived {0};
+    quint64 responsesReceived {0};
+    quint64 queriesSent {0};
+    quint64 responsesSent {0};
+
+    //! Records left out of responses because the querier already knew them
+    quint64 recordsSuppressed {0};
+
+    //! Rejected packets, indexed by ParseError
+    std::array<quint64, ParseErrorCount> parseFailures {};
+
+    PacketSizeHistogram receivedSizes;
+    PacketSizeHistogram sentSizes;
+
+    //! Per-interface counters, indexed by interface index (0 when unknown);
+    //! the first 64 interfaces with traffic are counted, later ones only in the totals
+    QMap<int, InterfaceStatistics> interfaces;
+};
+
+/**
+ * @brief Snapshot of the counters of a [Cache](@ref QtMdns::Cache)
+ */
+struct QTMDNS_EXPORT CacheStatistics
+{
+    quint64 records {0};     //! Number of records currently cached
+    quint64 insertions {0};  //! Records added or refreshed
+    quint64 hits {0};        //! Lookups that returned at least one record
+    quint64 misses {0};      //! Lookups that returned nothing
+    quint64 expirations {0}; //! Records removed by TTL expiry or goodbye
+    quint64 observed {0};    //! Records added by observing responses
+    quint64 observedBytes {0}; //! Estimated memory used by the observed records currently cached
+    quint64 evictions {0};   //! Observed records dropped to stay under the limit
+    quint64 negativeHits {0}; //! Lookups answered by a cached NSEC record
+};
+
+/**
+ * @brief Snapshot of the counters of a [Browser](@ref QtMdns::Browser)
+ */
+struct QTMDNS_EXPORT BrowserStatistics
+{
+    quint64 responsesProcessed {0};
+    quint64 queriesSent {0};
+    quint64 queriesSuppressed {0}; //! Queries not sent as another host asked the same question
+    quint64 knownAnswersSent {0}; //! Known answers included in queries
+    quint64 servicesAdded {0};
+    quint64 servicesUpdated {0};
+    quint64 servicesRemoved {0};
+};
+
+} // namespace QtMdns
+
+Q_DECLARE_METATYPE(QtMdns::ServerStatistics)
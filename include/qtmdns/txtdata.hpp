@@ -0,0 +1,203 @@
+#pragma once
+
+#include "qtmdns_export.hpp"
+
+#include <QByteArray>
+#include <QMap>
+
+#include <iterator>
+#include <optional>
+#include <string_view>
+
+namespace QtMdns {
+
+/**
+ * @brief Entry of a [TxtData](@ref QtMdns::TxtData)
+ *
+ * Entries point into the data they were read from and stay valid as long as
+ * that data is neither modified nor destroyed.
+ */
+class QTMDNS_EXPORT TxtEntry
+{
+public:
+    TxtEntry() = default;
+    TxtEntry(std::string_view key, std::string_view value, bool hasValue) :
+        m_key(key), m_value(value), m_hasValue(hasValue) {}
+
+    /**
+     * @brief Retrieve the key, as spelled in the record
+     */
+    std::string_view key() const { return m_key; }
+
+    /**
+     * @brief Retrieve the value, empty if the entry has none
+     */
+    std::string_view value() const { return m_value; }
+
+    /**
+     * @brief Determine if the entry has a value
+     *
+     * A key without '=' is a boolean attribute that has no value, which is
+     * not the same as an empty value ("key=").
+     */
+    bool hasValue() const { return m_hasValue; }
+
+private:
+    std::string_view m_key;
+    std::string_view m_value;
+    bool m_hasValue {false};
+};
+
+/**
+ * @brief Data of a TXT record, following RFC 6763 §6
+ *
+ * The data is stored as it appears in the record, a sequence of strings of up
+ * to 255 bytes each prefixed with its length, rather than being split into
+ * separate keys and values. Iterating over the entries and looking keys up
+ * reads that data in place without allocating, and it is written to packets
+ * as is.
+ *
+ * As in RFC 6763, keys are compared without regard to the case of ASCII
+ * letters, and only the first entry with a given key counts. Empty strings
+ * and entries with an empty key are ignored. Entries otherwise keep their
+ * order, duplicates included.
+ *
+ * New data is built by adding entries one at a time:
+ *
+ * @code
+ * QtMdns::TxtData txt;
+ * txt.add("txtvers", "1");
+ * txt.add("model", "ACME 3000");
+ * txt.add("color");
+ * for (QtMdns::TxtEntry const& entry : txt)
+ *     qDebug() << entry.key().data() << entry.hasValue();
+ * @endcode
+ */
+class QTMDNS_EXPORT TxtData
+{
+public:
+    /**
+     * @brief Forward iterator over the entries
+     */
+    class QTMDNS_EXPORT const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TxtEntry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = TxtEntry const*;
+        using reference = TxtEntry const&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return m_entry; }
+        pointer operator->() const { return &m_entry; }
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        bool operator==(const_iterator const& other) const { return m_position == other.m_position; }
+        bool operator!=(const_iterator const& other) const { return m_position != other.m_position; }
+
+    private:
+        friend class TxtData;
+        const_iterator(char const* position, char const* end);
+        void read();
+
+        char const* m_position {nullptr};  // Length byte of the current entry
+        char const* m_end {nullptr};
+        TxtEntry m_entry;
+    };
+
+    TxtData() = default;
+
+    /**
+     * @brief Create TXT data from the data of a record, as is
+     *
+     * Use isValid() to determine if the lengths of the strings match the
+     * size of the data.
+     */
+    explicit TxtData(QByteArray const& data);
+
+    /**
+     * @brief Create TXT data holding the given attributes, in key order
+     *
+     * A null value makes a boolean attribute, without '='.
+     */
+    static TxtData fromAttributes(QMap<QByteArray, QByteArray> const& attributes);
+
+    bool operator==(TxtData const& other) const { return m_data == other.m_data; }
+    bool operator!=(TxtData const& other) const { return m_data != other.m_data; }
+
+    /**
+     * @brief Determine if the strings exactly fill the data
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Determine if there are no entries
+     */
+    bool isEmpty() const { return begin() == end(); }
+
+    /**
+     * @brief Retrieve the number of entries, duplicates included
+     */
+    int count() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * @brief Find the first entry with the given key
+     */
+    std::optional<TxtEntry> find(std::string_view key) const;
+
+    /**
+     * @brief Determine if there is an entry with the given key
+     */
+    bool contains(std::string_view key) const { return find(key).has_value(); }
+
+    /**
+     * @brief Retrieve the value of the first entry with the given key
+     * @return the value, or a null array if the key is missing or has no value
+     */
+    QByteArray value(std::string_view key) const;
+
+    /**
+     * @brief Retrieve the attributes, the first entry of each key only
+     *
+     * Boolean attributes have a null value.
+     */
+    QMap<QByteArray, QByteArray> toMap() const;
+
+    /**
+     * @brief Append a boolean attribute
+     * @return false if the key is empty, contains '=' or is too long
+     */
+    bool add(std::string_view key);
+
+    /**
+     * @brief Append an attribute with a value
+     * @return false if the key is empty, contains '=' or if the entry is
+     * longer than 255 bytes
+     */
+    bool add(std::string_view key, std::string_view value);
+
+    /**
+     * @brief Remove all the entries with the given key
+     */
+    void remove(std::string_view key);
+
+    /**
+     * @brief Retrieve the data in the format of a TXT record
+     *
+     * The data is empty if there are no entries; a record must then hold a
+     * single empty string instead.
+     */
+    QByteArray const& toByteArray() const { return m_data; }
+
+private:
+    bool append(std::string_view key, std::string_view const* value);
+
+    QByteArray m_data;
+};
+
+} // namespace QtMdns
@@ -1,11 +1,289 @@
 #include <qtmdns/abstractserver.hpp>
+#include <qtmdns/message.hpp>
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QNetworkInterface>
+#include <QTimer>
+
+#include "announcer.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+namespace QtMdns {
+
+class AbstractServerPrivate
+{
+public:
+    using Counter = std::atomic<quint64>;
+
+    static void add(Counter& counter, quint64 value = 1)
+    {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    static quint64 load(Counter const& counter)
+    {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    // Counters of an interface; a slot is claimed by the first packet of the
+    // interface and keeps its index for the lifetime of the server
+    struct InterfaceSlot
+    {
+        std::atomic<int> index {FreeSlot};
+        Counter packetsReceived {0};
+        Counter packetsSent {0};
+        Counter bytesReceived {0};
+        Counter bytesSent {0};
+        Counter sendFailures {0};
+    };
+
+    static constexpr int FreeSlot = -1;
+    static constexpr size_t MaxInterfaces = 64;
+
+    // Find or claim the slot of an interface without locking, nullptr once
+    // all slots are taken: the packet is then only in the server totals
+    InterfaceSlot* interfaceSlot(int interfaceIndex)
+    {
+        for (InterfaceSlot& slot : interfaceSlots) {
+            int index = slot.index.load(std::memory_order_acquire);
+            if (index == FreeSlot
+                && slot.index.compare_exchange_strong(index, interfaceIndex, std::memory_order_acq_rel))
+            {
+                return &slot;
+            }
+            if (index == interfaceIndex)
+                return &slot;
+        }
+        return nullptr;
+    }
+
+    Counter packetsReceived {0};
+    Counter packetsSent {0};
+    Counter bytesReceived {0};
+    Counter bytesSent {0};
+    Counter sendFailures {0};
+    Counter queriesReceived {0};
+    Counter responsesReceived {0};
+    Counter queriesSent {0};
+    Counter responsesSent {0};
+    Counter recordsSuppressed {0};
+    std::array<Counter, ParseErrorCount> parseFailures {};
+    std::array<Counter, PacketSizeHistogram::Bounds.size() + 1> receivedSizes {};
+    std::array<Counter, PacketSizeHistogram::Bounds.size() + 1> sentSizes {};
+
+    std::array<InterfaceSlot, MaxInterfaces> interfaceSlots;
+
+    // Interface names, resolved by statistics() only
+    mutable QMutex namesMutex;
+    mutable QHash<int, QString> interfaceNames;
+
+    QTimer statisticsTimer;
+
+    std::shared_ptr<PacketTrace> trace;
+};
 
-using namespace QtMdns;
 
 AbstractServer::AbstractServer(QObject* parent)
-    : QObject(parent)
-{}
+    : QObject(parent),
+      dd_ptr(new AbstractServerPrivate)
+{
+    Q_D(AbstractServer);
+    connect(&d->statisticsTimer, &QTimer::timeout, this, [this]() {
+        emit statisticsUpdated(statistics());
+    });
+}
 
 AbstractServer::~AbstractServer()
 {
 }
+
+void AbstractServer::sendGoodbyes()
+{
+    if (Announcer* const announcer = findChild<Announcer*>(QString(), Qt::FindDirectChildrenOnly))
+        announcer->withdrawAll();
+}
+
+
+ServerStatistics AbstractServer::statistics() const
+{
+    Q_D(const AbstractServer);
+    using P = AbstractServerPrivate;
+
+    ServerStatistics stats;
+    stats.packetsReceived = P::load(d->packetsReceived);
+    stats.packetsSent = P::load(d->packetsSent);
+    stats.bytesReceived = P::load(d->bytesReceived);
+    stats.bytesSent = P::load(d->bytesSent);
+    stats.sendFailures = P::load(d->sendFailures);
+    stats.queriesReceived = P::load(d->queriesReceived);
+    stats.responsesReceived = P::load(d->responsesReceived);
+    stats.queriesSent = P::load(d->queriesSent);
+    stats.responsesSent = P::load(d->responsesSent);
+    stats.recordsSuppressed = P::load(d->recordsSuppressed);
+
+    for (size_t i = 0; i < stats.parseFailures.size(); ++i)
+        stats.parseFailures[i] = P::load(d->parseFailures[i]);
+
+    for (size_t i = 0; i < stats.receivedSizes.buckets.size(); ++i) {
+        stats.receivedSizes.buckets[i] = P::load(d->receivedSizes[i]);
+        stats.sentSizes.buckets[i] = P::load(d->sentSizes[i]);
+    }
+
+    QMutexLocker locker(&d->namesMutex);
+    for (P::InterfaceSlot const& slot : d->interfaceSlots) {
+        int const index = slot.index.load(std::memory_order_acquire);
+        if (index == P::FreeSlot)
+            break;
+
+        InterfaceStatistics interface;
+        interface.packetsReceived = P::load(slot.packetsReceived);
+        interface.packetsSent = P::load(slot.packetsSent);
+        interface.bytesReceived = P::load(slot.bytesReceived);
+        interface.bytesSent = P::load(slot.bytesSent);
+        interface.sendFailures = P::load(slot.sendFailures);
+
+        // Interfaces without traffic since the last reset are left out
+        if (interface.packetsReceived == 0 && interface.packetsSent == 0 && interface.sendFailures == 0)
+            continue;
+
+        if (index > 0) {
+            auto name = d->interfaceNames.find(index);
+            if (name == d->interfaceNames.end())
+                name = d->interfaceNames.insert(index, QNetworkInterface::interfaceNameFromIndex(index));
+            interface.name = name.value();
+        }
+        stats.interfaces.insert(index, interface);
+    }
+    return stats;
+}
+
+void AbstractServer::resetStatistics()
+{
+    Q_D(AbstractServer);
+    for (auto* counter : {&d->packetsReceived, &d->packetsSent, &d->bytesReceived,
+                          &d->bytesSent, &d->sendFailures, &d->queriesReceived,
+                          &d->responsesReceived, &d->queriesSent, &d->responsesSent,
+                          &d->recordsSuppressed})
+    {
+        counter->store(0, std::memory_order_relaxed);
+    }
+
+    for (auto& counter : d->parseFailures)
+        counter.store(0, std::memory_order_relaxed);
+    for (auto& counter : d->receivedSizes)
+        counter.store(0, std::memory_order_relaxed);
+    for (auto& counter : d->sentSizes)
+        counter.store(0, std::memory_order_relaxed);
+
+    for (auto& slot : d->interfaceSlots) {
+        for (auto* counter : {&slot.packetsReceived, &slot.packetsSent, &slot.bytesReceived,
+                              &slot.bytesSent, &slot.sendFailures})
+        {
+            counter->store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void AbstractServer::setStatisticsInterval(int msecs)
+{
+    Q_D(AbstractServer);
+    if (msecs > 0)
+        d->statisticsTimer.start(msecs);
+    else
+        d->statisticsTimer.stop();
+}
+
+void AbstractServer::countSuppressedRecords(int count)
+{
+    Q_D(AbstractServer);
+    if (count > 0)
+        AbstractServerPrivate::add(d->recordsSuppressed, count);
+}
+
+std::shared_ptr<PacketTrace> AbstractServer::packetTrace() const
+{
+    Q_D(const AbstractServer);
+    return d->trace;
+}
+
+void AbstractServer::setPacketTrace(std::shared_ptr<PacketTrace> trace)
+{
+    Q_D(AbstractServer);
+    d->trace = std::move(trace);
+}
+
+void AbstractServer::tracePacket(TracedPacket::Direction direction, QByteArray const& packet,
+                                 QHostAddress const& address, quint16 port, int interfaceIndex)
+{
+    Q_D(AbstractServer);
+    if ( ! d->trace)
+        return;
+
+    using namespace std::chrono;
+    TracedPacket traced;
+    traced.timestamp = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    traced.direction = direction;
+    traced.interfaceIndex = interfaceIndex;
+    traced.address = address;
+    traced.port = port;
+    traced.data = packet;
+    d->trace->add(std::move(traced));
+}
+
+void AbstractServer::countPacketReceived(qsizetype size, int interfaceIndex)
+{
+    Q_D(AbstractServer);
+    AbstractServerPrivate::add(d->packetsReceived);
+    AbstractServerPrivate::add(d->bytesReceived, size);
+    AbstractServerPrivate::add(d->receivedSizes[PacketSizeHistogram::bucket(size)]);
+
+    if (auto* const slot = d->interfaceSlot(interfaceIndex)) {
+        AbstractServerPrivate::add(slot->packetsReceived);
+        AbstractServerPrivate::add(slot->bytesReceived, size);
+    }
+}
+
+void AbstractServer::countPacketSent(qsizetype size, int interfaceIndex, bool success)
+{
+    Q_D(AbstractServer);
+    if (success) {
+        AbstractServerPrivate::add(d->packetsSent);
+        AbstractServerPrivate::add(d->bytesSent, size);
+        AbstractServerPrivate::add(d->sentSizes[PacketSizeHistogram::bucket(size)]);
+    } else {
+        AbstractServerPrivate::add(d->sendFailures);
+    }
+
+    auto* const slot = d->interfaceSlot(interfaceIndex);
+    if ( ! slot)
+        return;
+
+    if (success) {
+        AbstractServerPrivate::add(slot->packetsSent);
+        AbstractServerPrivate::add(slot->bytesSent, size);
+    } else {
+        AbstractServerPrivate::add(slot->sendFailures);
+    }
+}
+
+void AbstractServer::countParseFailure(ParseError reason)
+{
+    Q_D(AbstractServer);
+    AbstractServerPrivate::add(d->parseFailures[static_cast<int>(reason)]);
+}
+
+void AbstractServer::countMessage(Message const& message, bool sent)
+{
+    Q_D(AbstractServer);
+    if (sent)
+        AbstractServerPrivate::add(message.isResponse() ? d->responsesSent : d->queriesSent);
+    else
+        AbstractServerPrivate::add(message.isResponse() ? d->responsesReceived : d->queriesReceived);
+}
+
+} // namespace QtMdns
@@ -0,0 +1,149 @@
+#include <qtmdns/abstractserver.hpp>
+#include <qtmdns/dns.hpp>
+#include <qtmdns/mdns.hpp>
+#include <qtmdns/message.hpp>
+
+#include "announcer.hpp"
+
+#include <algorithm>
+
+namespace QtMdns {
+
+namespace {
+
+constexpr int AnnouncementCount = 3;
+constexpr qint64 FirstInterval = 1000;
+
+// Announcements due this close to the earliest one are sent with it
+constexpr qint64 MergeWindow = 100;
+
+} // namespace
+
+
+Announcer* Announcer::instance(AbstractServer* server)
+{
+    Announcer* announcer = server->findChild<Announcer*>(QString(), Qt::FindDirectChildrenOnly);
+    if ( ! announcer)
+        announcer = new Announcer(server);
+    return announcer;
+}
+
+Announcer::Announcer(AbstractServer* server) :
+    QObject(server),
+    server(server),
+    timer([this]() { onTimeout(); })
+{
+    timer.setServer(server);
+    clock.start();
+}
+
+void Announcer::announce(QObject const* owner, QList<Record> const& records)
+{
+    cancel(owner);
+    published.insert(owner, records);
+
+    // The first announcement goes out once control returns to the event
+    // loop, with those of the other owners updated meanwhile
+    qint64 const now = clock.elapsed();
+    for (Record const& record : records)
+        announcements.append({owner, record, AnnouncementCount, FirstInterval, now});
+
+    schedule();
+}
+
+void Announcer::cancel(QObject const* owner)
+{
+    published.remove(owner);
+    announcements.erase(std::remove_if(announcements.begin(), announcements.end(),
+                                       [owner](Announcement const& a) { return a.owner == owner; }),
+                        announcements.end());
+    schedule();
+}
+
+void Announcer::withdraw(QObject const* owner)
+{
+    QList<Record> records = published.value(owner);
+    cancel(owner);
+
+    for (Record& record : records) {
+        record.setTtl(0);
+        goodbyes.append(std::move(record));
+    }
+    schedule();
+}
+
+void Announcer::withdrawAll()
+{
+    for (auto i = published.cbegin(); i != published.cend(); ++i) {
+        for (Record record : i.value()) {
+            record.setTtl(0);
+            goodbyes.append(std::move(record));
+        }
+    }
+    published.clear();
+    announcements.clear();
+    timer.stop();
+
+    send(goodbyes);
+    goodbyes.clear();
+}
+
+void Announcer::schedule()
+{
+    if ( ! goodbyes.isEmpty()) {
+        timer.start(0);
+        return;
+    }
+
+    if (announcements.isEmpty()) {
+        timer.stop();
+        return;
+    }
+
+    qint64 due = announcements.first().due;
+    for (Announcement const& announcement : qAsConst(announcements))
+        due = qMin(due, announcement.due);
+
+    timer.start(static_cast<int>(qMax<qint64>(0, due - clock.elapsed())));
+}
+
+void Announcer::onTimeout()
+{
+    qint64 const now = clock.elapsed();
+
+    QList<Record> records;
+    records.swap(goodbyes);
+
+    for (auto i = announcements.begin(); i != announcements.end();) {
+        if (i->due > now + MergeWindow) {
+            ++i;
+            continue;
+        }
+
+        records.append(i->record);
+        if (--i->remaining == 0) {
+            i = announcements.erase(i);
+        } else {
+            i->due = now + i->interval;
+            i->interval *= 2;
+            ++i;
+        }
+    }
+
+    send(records);
+    schedule();
+}
+
+void Announcer::send(QList<Record> const& records)
+{
+    Message message;
+        message.setResponse(true);
+    for (Record const& record : records)
+        message.addRecord(record);
+
+    const auto messages = splitMessage(message, mdnsDefaults().MdnsMaxPacketSize);
+    for (Message const& part : messages)
+        server->sendMessageToAll(part);
+}
+
+} // namespace QtMdns
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <qtmdns/record.hpp>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include "timerqueue.hpp"
+
+namespace QtMdns {
+
+class AbstractServer;
+
+/**
+ * @brief Unsolicited responses of all the local records of a server
+ *
+ * RFC 6762 §8.3: once records are confirmed unique, or updated, they are
+ * announced at least twice, one second apart, the interval doubling after
+ * each announcement. Announcements of all the owners of a server (providers,
+ * hostnames) share a single timer, and those falling due together are sent
+ * in the same message.
+ *
+ * Goodbye records, which have a TTL of 0, are sent once, with the next batch.
+ * The announcer also keeps the records each owner published, so that they can
+ * all be withdrawn at once when the server shuts down.
+ *
+ * Batches are split into messages that fit in a single Ethernet frame.
+ */
+class Announcer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Retrieve the announcer of a server, creating it if needed
+     */
+    static Announcer* instance(AbstractServer* server);
+
+    /**
+     * @brief Announce the records of an owner
+     *
+     * Pending announcements of the owner are replaced: each record is sent
+     * again with the next batch, then repeated.
+     */
+    void announce(QObject const* owner, QList<Record> const& records);
+
+    /**
+     * @brief Cancel the announcements of an owner
+     */
+    void cancel(QObject const* owner);
+
+    /**
+     * @brief Send goodbye records for the records of an owner with the next batch
+     *
+     * The announcements of the owner are cancelled.
+     */
+    void withdraw(QObject const* owner);
+
+    /**
+     * @brief Immediately send goodbye records for the records of all owners
+     *
+     * Goodbye records waiting for the next batch are sent too. Owners are
+     * forgotten, withdrawing them later sends nothing.
+     */
+    void withdrawAll();
+
+private:
+    explicit Announcer(AbstractServer* server);
+
+    struct Announcement
+    {
+        QObject const* owner;
+        Record record;
+        int remaining;     // Announcements left to send
+        qint64 interval;   // Delay before the next one
+        qint64 due;        // Time of the next one, relative to clock
+    };
+
+    void schedule();
+    void onTimeout();
+    void send(QList<Record> const& records);
+
+    AbstractServer* const server;
+    QueuedTimer timer;
+    QElapsedTimer clock;
+    QList<Announcement> announcements;
+    QHash<QObject const*, QList<Record>> published;
+    QList<Record> goodbyes;
+};
+
+} // namespace QtMdns
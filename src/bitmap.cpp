@@ -1,73 +1,50 @@
 #include <qtmdns/bitmap.hpp>
 
-namespace QtMdns {
-
-class BitmapPrivate
-{
-public:
-    BitmapPrivate()
-    {}
-
-    void fromData(std::vector<quint8> newData)
-    {
-        data = std::move(newData);
-    }
-
-    std::vector<quint8> data;
-};
+#include <algorithm>
+#include <cstring>
 
+namespace QtMdns {
 
-Bitmap::Bitmap() :
-    dd_ptr(new BitmapPrivate)
-{}
-
-Bitmap::Bitmap(Bitmap const& other) :
-    dd_ptr(new BitmapPrivate)
+bool Bitmap::operator==(Bitmap const& other) const
 {
-    Q_D(Bitmap);
-    d->fromData(other.dd_ptr->data);
+    return size == other.size && std::memcmp(bits.data(), other.bits.data(), size) == 0;
 }
 
-Bitmap& Bitmap::operator=(Bitmap const& other)
-{
-    Q_D(Bitmap);
-    d->fromData(other.dd_ptr->data);
-    return *this;
-}
 
-bool Bitmap::operator==(Bitmap const& other) const
+size_t Bitmap::length() const
 {
-    Q_D(const Bitmap);
-    return d->data == other.dd_ptr->data;
+    return size;
 }
 
-Bitmap::~Bitmap()
+quint8 const* Bitmap::data() const
 {
+    return bits.data();
 }
 
-
-size_t Bitmap::length() const
+void Bitmap::setData(quint8 length, quint8 const* data)
 {
-    Q_D(const Bitmap);
-    return d->data.size();
+    size = static_cast<quint8>(qMin<size_t>(length, MaxLength));
+    bits.fill(0);
+    std::copy_n(data, size, bits.begin());
 }
 
-quint8 const* Bitmap::data() const
+void Bitmap::setData(std::vector<quint8> const& data)
 {
-    Q_D(const Bitmap);
-    return d->data.data();
+    setData(static_cast<quint8>(qMin<size_t>(data.size(), MaxLength)), data.data());
 }
 
-void Bitmap::setData(quint8 length, quint8 const* data)
+bool Bitmap::contains(quint16 type) const
 {
-    Q_D(Bitmap);
-    d->fromData(std::vector<quint8>(data, data+length));
+    return type / 8u < size && (bits[type / 8u] & (0x80 >> (type % 8u)));
 }
 
-void Bitmap::setData(std::vector<quint8> data)
+void Bitmap::insert(quint16 type)
 {
-    Q_D(Bitmap);
-    d->fromData(std::move(data));
+    if (type / 8u >= MaxLength)
+        return;
+
+    bits[type / 8u] |= 0x80 >> (type % 8u);
+    size = static_cast<quint8>(qMax<size_t>(size, type / 8u + 1));
 }
 
 } // namespace QtMdns
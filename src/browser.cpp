@@ -2,6 +2,7 @@
 #include <qtmdns/browser.hpp>
 #include <qtmdns/cache.hpp>
 #include <qtmdns/dns.hpp>
+#include <qtmdns/domainname.hpp>
 #include <qtmdns/mdns.hpp>
 #include <qtmdns/message.hpp>
 #include <qtmdns/query.hpp>
@@ -9,14 +10,35 @@
 #include <qtmdns/service.hpp>
 
 #include <QByteArray>
-#include <QMap>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 #include <QPointer>
 #include <QSet>
 #include <QTimer>
 
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+#include <QRandomGenerator>
+#define USE_QRANDOMGENERATOR
+#endif
+
+#include <algorithm>
+
+#include "timerqueue.hpp"
+
 namespace QtMdns {
 
+namespace {
+
+// RFC 6762 §5.2: the first query is sent after 20 to 120 ms, the next one a
+// second later, and the interval then doubles up to an hour
+constexpr int FirstQueryMinDelay = 20;
+constexpr int FirstQueryMaxDelay = 120;
+constexpr qint64 FirstQueryInterval = 1000;
+constexpr qint64 MaxQueryInterval = 60 * 60 * 1000;
+
+} // namespace
+
 class BrowserPrivate : public QObject
 {
     Q_DISABLE_COPY_MOVE(BrowserPrivate)
@@ -29,19 +51,26 @@ public:
         q_ptr(browser),
         server(server),
         type(std::move(_type)),
-        cache(existingCache ? std::move(existingCache) : std::make_shared<Cache>())
+        typeName(type),
+        browseType(mdnsDefaults().MdnsBrowseType),
+        cache(existingCache ? existingCache : std::make_shared<Cache>()),
+        queryTimer([this]() { onQueryTimeout(); }),
+        serviceTimer([this]() { onServiceTimeout(); })
     {
         connect(server, &AbstractServer::messageReceived, this, &BrowserPrivate::onMessageReceived);
         connect(cache.get(), &Cache::shouldQuery, this, &BrowserPrivate::onShouldQuery);
         connect(cache.get(), &Cache::recordExpired, this, &BrowserPrivate::onRecordExpired);
-        connect(&queryTimer, &QTimer::timeout, this, &BrowserPrivate::onQueryTimeout);
-        connect(&serviceTimer, &QTimer::timeout, this, &BrowserPrivate::onServiceTimeout);
 
-        queryTimer.setInterval(60 * 1000);
-        queryTimer.setSingleShot(true);
+        // A cache of its own is only used with this server
+        if ( ! existingCache)
+            cache->setTimerServer(server);
 
+        queryTimer.setServer(server);
+        queryTimer.setSlack(FirstQueryMinDelay);
+
+        serviceTimer.setServer(server);
         serviceTimer.setInterval(100);
-        serviceTimer.setSingleShot(true);
+        serviceTimer.setSlack(20);
 
         // Immediately begin browsing for services
         if ( ! type.isEmpty())
@@ -49,9 +78,97 @@ public:
     }
     ~BrowserPrivate() override = default;
 
+    // Browsing for MdnsBrowseType enumerates the service types, and browses
+    // for instances of each of them
+    bool isEnumerating() const
+    {
+        return typeName == browseType;
+    }
+
     void start()
     {
-        onQueryTimeout();
+        // Types are discovered when enumerating, otherwise the only one is
+        // the browsed type
+        instances.clear();
+        instanceTypes.clear();
+        if ( ! isEnumerating())
+            instances.insert(typeName, {});
+
+        // Start over with short intervals
+        queryInterval = FirstQueryInterval;
+        clock.start();
+#ifdef USE_QRANDOMGENERATOR
+        scheduleQuery(QRandomGenerator::global()->bounded(FirstQueryMinDelay, FirstQueryMaxDelay + 1));
+#else
+        scheduleQuery(FirstQueryMinDelay + qrand() % (FirstQueryMaxDelay - FirstQueryMinDelay + 1));
+#endif
+
+        // Report the services the cache already knows once control returns
+        // to the event loop, so that signals can be connected first
+        QTimer::singleShot(0, this, &BrowserPrivate::loadFromCache);
+    }
+
+    // Services found in a shared cache, filled by other browsers or by
+    // observing responses, are reported without waiting for responses
+    void loadFromCache()
+    {
+        if (type.isEmpty())
+            return;
+
+        QList<Record> ptrRecords;
+        if (isEnumerating()) {
+            cache->lookupRecords(browseType, PTR, ptrRecords);
+            for (Record const& ptrRecord : qAsConst(ptrRecords)) {
+                if (ptrRecord.domainName() == browseType && ! instances.contains(ptrRecord.targetName()))
+                    instances.insert(ptrRecord.targetName(), {});
+            }
+        }
+
+        for (auto it = instances.begin(); it != instances.end(); ++it) {
+            ptrRecords.clear();
+            cache->lookupRecords(it.key(), PTR, ptrRecords);
+            for (Record const& ptrRecord : qAsConst(ptrRecords)) {
+                if (ptrRecord.domainName() == it.key()) {
+                    it->insert(ptrRecord.targetName());
+                    instanceTypes.insert(ptrRecord.targetName(), it.key());
+                    cache->retainRecord(ptrRecord);
+                }
+            }
+        }
+
+        for (auto it = instances.cbegin(); it != instances.cend(); ++it) {
+            for (DomainName const& fqName : *it) {
+                const auto srvRecords = lookupSrvRecords(fqName);
+                for (Record const& srvRecord : srvRecords)
+                    hostnames.insert(srvRecord.targetName());
+                updateService(fqName);
+            }
+        }
+    }
+
+    // Check if a record belongs to an instance of one of the browsed types;
+    // the type is the one of the PTR record, as instances found browsing a
+    // subtype are not named after it
+    bool isKnownInstance(DomainName const& fqName) const
+    {
+        return instanceTypes.contains(fqName);
+    }
+
+    // Forget an instance of a browsed type, unless another one still has it
+    void removeInstance(DomainName const& browsedType, DomainName const& fqName)
+    {
+        if (auto const it = instances.find(browsedType); it != instances.end())
+            it->remove(fqName);
+        if (instanceTypes.value(fqName) != browsedType)
+            return;
+
+        instanceTypes.remove(fqName);
+        for (auto it = instances.cbegin(); it != instances.cend(); ++it) {
+            if (it->contains(fqName)) {
+                instanceTypes.insert(fqName, it.key());
+                return;
+            }
+        }
     }
     void stop()
     {
@@ -59,41 +176,75 @@ public:
         serviceTimer.stop();
     }
 
-    // TODO: multiple SRV records not supported
-    bool updateService(QByteArray const& fqName)
+    // SRV records of an instance, ordered by priority, then by decreasing
+    // weight, so that the preferred target comes first
+    QList<Record> lookupSrvRecords(DomainName const& fqName) const
     {
-        // Split the FQDN into service name and type
-        qsizetype const index = fqName.indexOf("._");
-        QByteArray const serviceName = fqName.left(index);
-        QByteArray const serviceType = fqName.mid(index + 1);
-
-        // Immediately return if a PTR record does not exist
-        Record ptrRecord;
-        if (!cache->lookupRecord(serviceType, PTR, ptrRecord))
+        QList<Record> records;
+        cache->lookupRecords(fqName, SRV, records);
+        records.erase(std::remove_if(records.begin(), records.end(),
+                                     [&](Record const& record) { return record.domainName() != fqName; }),
+                      records.end());
+        std::stable_sort(records.begin(), records.end(), [](Record const& a, Record const& b) {
+            return a.priority() != b.priority() ? a.priority() < b.priority() : a.weight() > b.weight();
+        });
+        return records;
+    }
+
+    bool updateService(DomainName const& fqName)
+    {
+        // Split the FQDN into service name (the first label, which may
+        // contain dots) and type
+        QByteArray const serviceName = fqName.label(0);
+        DomainName const serviceType = fqName.parent();
+
+        // Immediately return if no PTR record points to the instance
+        if ( ! isKnownInstance(fqName))
             return false;
 
-        // If a SRV record is missing, query for it (by returning true)
-        Record srvRecord;
-        if (!cache->lookupRecord(fqName, SRV, srvRecord))
+        // If SRV records are missing, query for them (by returning true)
+        QList<Record> const srvRecords = lookupSrvRecords(fqName);
+        if (srvRecords.isEmpty())
             return true;
 
-        Record aRecord;
-        cache->lookupRecord(srvRecord.target(), A, aRecord);
-        Record aaaaRecord;
-        cache->lookupRecord(srvRecord.target(), AAAA, aaaaRecord);
+        // Each SRV record is a target, with all the addresses of its host;
+        // those are sorted so that the order does not depend on when their
+        // records were last renewed
+        QList<ServiceTarget> targets;
+        QList<ServiceAddress> addresses;
+        QList<Record> used = srvRecords;
+        for (Record const& srvRecord : srvRecords) {
+            targets.append({srvRecord.target(), srvRecord.port(), srvRecord.priority(), srvRecord.weight()});
+
+            QList<Record> addressRecords;
+            cache->lookupRecords(srvRecord.targetName(), A, addressRecords);
+            cache->lookupRecords(srvRecord.targetName(), AAAA, addressRecords);
+            qsizetype const first = addresses.size();
+            for (Record const& record : qAsConst(addressRecords)) {
+                ServiceAddress address {record.address(), srvRecord.target(), record.ttl()};
+                if (record.domainName() == srvRecord.targetName() && ! addresses.contains(address)) {
+                    addresses.append(std::move(address));
+                    used.append(record);
+                }
+            }
+            std::sort(addresses.begin() + first, addresses.end(), [](ServiceAddress const& a, ServiceAddress const& b) {
+                if (a.address.protocol() != b.address.protocol())
+                    return a.address.protocol() == QAbstractSocket::IPv4Protocol;
+                return a.address.toString() < b.address.toString();
+            });
+        }
 
         Service service;
         service.setName(serviceName);
-        service.setType(serviceType);
-        service.setHostname(srvRecord.target());
-        service.setPort(srvRecord.port());
-        service.setHostAddress(aRecord.address());
-        service.setHostAddressIPv6(aaaaRecord.address());
+        service.setType(serviceType.toByteArray());
+        service.setTargets(targets);
+        service.setAddresses(addresses);
 
         // If TXT records are available for the service, add their values
         QList<Record> txtRecords;
         if (cache->lookupRecords(fqName, TXT, txtRecords)) {
             QMap<QByteArray, QByteArray> attributes;
+            used.append(txtRecords);
             for (Record const& record : qAsConst(txtRecords)) {
                 auto const attrs = record.attributes();
                 for (auto it = attrs.cbegin(); it != attrs.cend(); ++it) {
@@ -103,11 +254,18 @@ public:
             service.setAttributes(attributes);
         }
 
+        // Records observed by a shared cache are renewed from now on, like
+        // those this browser received
+        for (Record const& record : qAsConst(used))
+            cache->retainRecord(record);
+
         // If the service existed, this is an update; otherwise it is a new
         // addition; emit the appropriate signal
         if (!services.contains(fqName)) {
+            ++stats.servicesAdded;
             emit q_ptr->serviceAdded(service);
         } else if (services.value(fqName) != service) {
+            ++stats.servicesUpdated;
             emit q_ptr->serviceUpdated(service);
         }
 
@@ -118,38 +276,47 @@ public:
 
     void onMessageReceived(const Message &message)
     {
-        if ( ! message.isResponse())
+        if ( ! message.isResponse()) {
+            onQueryReceived(message);
             return;
+        }
 
-        bool const any = (type == mdnsDefaults().MdnsBrowseType);
+        ++stats.responsesProcessed;
 
         // Use a set to track all services that are updated in the message to
         // prevent unnecessary queries for SRV and TXT records
-        QSet<QByteArray> updateNames;
+        QSet<DomainName> updateNames;
         QList<Record> const records = message.records();
         for (Record const& record : records) {
             bool cacheRecord = false;
 
             switch (record.type()) {
             case PTR:
-                if (any && record.name() == mdnsDefaults().MdnsBrowseType) {
-                    ptrTargets.insert(record.target());
-                    serviceTimer.start();
+                if (isEnumerating() && record.domainName() == browseType) {
+                    // Instances of a new type are queried with those of the
+                    // other types found meanwhile
+                    if ( ! instances.contains(record.targetName())) {
+                        instances.insert(record.targetName(), {});
+                        ptrTargets.insert(record.targetName());
+                        serviceTimer.start();
+                    }
                     cacheRecord = true;
-                } else if (any || record.name() == type) {
-                    domainName = record.target(); // MAYBE: Should it be reset somewhere?
-                    updateNames.insert(record.target());
+                } else if (instances.contains(record.domainName())) {
+                    if (record.ttl() > 0) {
+                        instances[record.domainName()].insert(record.targetName());
+                        instanceTypes.insert(record.targetName(), record.domainName());
+                    }
+                    updateNames.insert(record.targetName());
                     cacheRecord = true;
                 }
                 break;
             case SRV:
             case TXT:
-                // Filter records by the domain name in PTR
-                //if (any || record.name().endsWith("." + localType)) {
-                if (any || record.name() == domainName) {
-                    updateNames.insert(record.name());
+                // Filter records by the instances the PTR records point to
+                if (isKnownInstance(record.domainName())) {
+                    updateNames.insert(record.domainName());
                     if (record.type() == SRV)
-                        hostnames.insert(record.target());
+                        hostnames.insert(record.targetName());
                     cacheRecord = true;
                 }
                 break;
@@ -161,14 +328,37 @@ public:
                 cache->addRecord(record);
         }
 
-        // Cache A / AAAA records after services are processed to ensure hostnames are known
+        // Cache A / AAAA records after services are processed to ensure hostnames are known;
+        // NSEC records of hosts and services tell which records not to query
+        QSet<DomainName> updatedHosts;
         for (const Record &record : records) {
             bool cacheRecord = false;
 
             switch (record.type()) {
             case A:
             case AAAA:
-                cacheRecord = hostnames.contains(record.name());
+                if (hostnames.contains(record.domainName())) {
+                    updatedHosts.insert(record.domainName());
+                    cacheRecord = true;
+                }
+
+                // Link-local addresses are only reachable through the
+                // interface they were received on
+                if (cacheRecord && record.address().isLinkLocal() && record.address().scopeId().isEmpty()
+                    && ! message.address().scopeId().isEmpty())
+                {
+                    QHostAddress address = record.address();
+                    address.setScopeId(message.address().scopeId());
+                    Record scoped = record;
+                    scoped.setAddress(address);
+                    cache->addRecord(scoped);
+                    cacheRecord = false;
+                }
+                break;
+            case NSEC:
+                cacheRecord = hostnames.contains(record.domainName())
+                        || updateNames.contains(record.domainName())
+                        || services.contains(record.domainName());
                 break;
             default:
                 break;
@@ -178,10 +368,15 @@ public:
                 cache->addRecord(record);
         }
 
+        // Services of the hosts whose addresses changed are updated too; only
+        // a change of the set of addresses is reported
+        if ( ! updatedHosts.isEmpty())
+            updateNames.unite(servicesOfHosts(updatedHosts));
+
         // For each of the services marked to be updated, perform the update and
         // make a list of all missing SRV records
-        QSet<QByteArray> queryNames;
-        for (const QByteArray &name : qAsConst(updateNames)) {
+        QSet<DomainName> queryNames;
+        for (DomainName const& name : qAsConst(updateNames)) {
             if (updateService(name)) {
                 queryNames.insert(name);
             }
@@ -190,18 +385,53 @@ public:
         // Build and send a query for all of the SRV and TXT records
         if (queryNames.count()) {
             Message queryMessage;
-            for (const QByteArray &name : qAsConst(queryNames)) {
-                Query query;
-                query.setName(name);
-                query.setType(SRV);
-                queryMessage.addQuery(query);
-                query.setType(TXT);
-                queryMessage.addQuery(query);
+            for (DomainName const& name : qAsConst(queryNames)) {
+                for (quint16 const type : {SRV, TXT}) {
+                    if (cache->isNegative(name, type))
+                        continue;
+
+                    Query query;
+                    query.setName(name.toByteArray());
+                    query.setType(type);
+                    queryMessage.addQuery(query);
+                }
             }
-            server->sendMessageToAll(queryMessage);
+            if ( ! queryMessage.queries().isEmpty())
+                sendQuery(queryMessage);
         }
     }
 
+    // RFC 6762 §7.3: another host asking the question of the next query,
+    // with no known answer this browser does not have, gets the same
+    // responses; the query is then considered sent. Only questions seen in
+    // the second half of the wait count, which leaves out the echo of the
+    // last query.
+    void onQueryReceived(const Message &message)
+    {
+        if (type.isEmpty() || ! queryTimer.isActive() || (queryDue - clock.elapsed()) * 2 > queryWait)
+            return;
+
+        bool asked = false;
+        const auto queries = message.queries();
+        for (Query const& query : queries) {
+            if (query.type() == PTR && query.domainName() == typeName && ! query.unicastResponse())
+                asked = true;
+        }
+        if ( ! asked)
+            return;
+
+        QList<Record> known;
+        cache->lookupRecords(typeName, PTR, known);
+        const auto records = message.records();
+        for (Record const& record : records) {
+            if (record.type() == PTR && record.domainName() == typeName && ! known.contains(record))
+                return;
+        }
+
+        ++stats.queriesSuppressed;
+        scheduleNextQuery();
+    }
+
     void onShouldQuery(const Record &record)
     {
         // Assume that all messages in the cache are still in use (by the browser)
@@ -214,7 +444,7 @@ public:
         Message message;
             message.addQuery(query);
 
-        server->sendMessageToAll(message);
+        sendQuery(message);
     }
 
     void onRecordExpired(const Record &record)
@@ -222,14 +452,37 @@ public:
         // If the SRV record has expired for a service, then it must be
         // removed - TXT records on the other hand, cause an update
 
-        QByteArray serviceName;
+        DomainName serviceName;
         switch (record.type()) {
+        case PTR:
+            if (record.domainName() == browseType)
+                return;
+            // The instance is gone, unless another browsed type has it too
+            serviceName = record.targetName();
+            removeInstance(record.domainName(), serviceName);
+            if (isKnownInstance(serviceName))
+                return;
+            break;
         case SRV:
-            serviceName = record.name();
+            // The other targets of the service remain
+            if ( ! lookupSrvRecords(record.domainName()).isEmpty()) {
+                updateService(record.domainName());
+                updateHostnames();
+                return;
+            }
+            serviceName = record.domainName();
             break;
         case TXT:
-            updateService(record.name());
+            updateService(record.domainName());
             return;
+        case A:
+        case AAAA: {
+            // Other addresses of the host may remain
+            const auto names = servicesOfHosts({record.domainName()});
+            for (DomainName const& name : names)
+                updateService(name);
+            return;
+        }
 
         default:
             return;
@@ -237,6 +490,7 @@ public:
 
         Service const service = services.value(serviceName);
         if ( ! service.name().isNull()) {
+            ++stats.servicesRemoved;
             emit q_ptr->serviceRemoved(service);
             services.remove(serviceName);
             updateHostnames();
@@ -259,24 +513,38 @@ public:
 
         // Include PTR records for the target that are already known
         QList<Record> records;
-        if (cache->lookupRecords(query.name(), PTR, records)) {
+        if (cache->lookupRecords(query.domainName(), PTR, records)) {
             for (const Record &record : qAsConst(records)) {
                 message.addRecord(record);
             }
         }
 
-        server->sendMessageToAll(message);
-        queryTimer.start();
+        sendQuery(message);
+        scheduleNextQuery();
+    }
+
+    void scheduleQuery(qint64 delay)
+    {
+        queryWait = delay;
+        queryDue = clock.elapsed() + delay;
+        queryTimer.start(static_cast<int>(delay));
+    }
+
+    // Wait for the current interval, and double it for the next query
+    void scheduleNextQuery()
+    {
+        scheduleQuery(queryInterval);
+        queryInterval = qMin(queryInterval * 2, MaxQueryInterval);
     }
 
     void onServiceTimeout()
     {
         if (ptrTargets.count()) {
             Message message;
-            for (const QByteArray &target : qAsConst(ptrTargets)) {
+            for (DomainName const& target : qAsConst(ptrTargets)) {
                 // Add a query for PTR records
                 Query query;
-                    query.setName(target);
+                    query.setName(target.toByteArray());
                     query.setType(PTR);
 
                 message.addQuery(query);
@@ -290,31 +558,62 @@ public:
                 }
             }
 
-            server->sendMessageToAll(message);
+            sendQuery(message);
             ptrTargets.clear();
         }
     }
 
 private:
+    void sendQuery(Message const& message)
+    {
+        ++stats.queriesSent;
+        stats.knownAnswersSent += message.records().count();
+        server->sendMessageToAll(message);
+    }
+
+    QSet<DomainName> servicesOfHosts(QSet<DomainName> const& hosts) const
+    {
+        QSet<DomainName> names;
+        for (auto it = services.cbegin(); it != services.cend(); ++it) {
+            const auto targets = it->targets();
+            for (ServiceTarget const& target : targets) {
+                if (hosts.contains(DomainName(target.hostname)))
+                    names.insert(it.key());
+            }
+        }
+        return names;
+    }
+
     void updateHostnames()
     {
         hostnames.clear();
         for (Service const& service : qAsConst(services)) {
-            hostnames.insert(service.hostname());
+            const auto targets = service.targets();
+            for (ServiceTarget const& target : targets)
+                hostnames.insert(DomainName(target.hostname));
         }
     }
 
     QPointer<AbstractServer> server;
     QByteArray type;
-    QByteArray domainName;
+    DomainName typeName;
+    DomainName const browseType;
 
     std::shared_ptr<Cache> cache;
-    QSet<QByteArray> ptrTargets;
-    QMap<QByteArray, Service> services;
-    QSet<QByteArray> hostnames;
-
-    QTimer queryTimer;
-    QTimer serviceTimer;
+    QHash<DomainName, QSet<DomainName>> instances;  // Instances of each browsed type
+    QHash<DomainName, DomainName> instanceTypes;    // Browsed type each instance was found with
+    QSet<DomainName> ptrTargets;                     // Types to query instances of
+    QHash<DomainName, Service> services;
+    QSet<DomainName> hostnames;
+
+    QueuedTimer queryTimer;
+    QueuedTimer serviceTimer;
+    QElapsedTimer clock;
+    qint64 queryInterval {FirstQueryInterval};  // Delay after the next query
+    qint64 queryWait {0};                       // Delay before the next query
+    qint64 queryDue {0};                        // Time of the next query, relative to clock
+
+    BrowserStatistics stats;
 };
 
 
@@ -350,15 +649,22 @@ void Browser::startLookup(QByteArray type)
     if (d->type == type)
         return;
 
-    bool const needStart = d->type.isEmpty();
     d->type = type;
+    d->typeName = DomainName(d->type);
 
     // TODO: cleanup?
 
+    // Queries for a new type start over with short intervals
     if (d->type.isEmpty())
         d->stop();
-    else if (needStart)
+    else
         d->start();
 }
 
+BrowserStatistics Browser::statistics() const
+{
+    Q_D(const Browser);
+    return d->stats;
+}
+
 } // namespace QtMdns
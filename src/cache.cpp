@@ -1,5 +1,9 @@
+#include <qtmdns/abstractserver.hpp>
+#include <qtmdns/bitmap.hpp>
 #include <qtmdns/cache.hpp>
 #include <qtmdns/dns.hpp>
+#include <qtmdns/domainname.hpp>
+#include <qtmdns/message.hpp>
 #include <qtmdns/record.hpp>
 
 #include <QtGlobal>
@@ -9,10 +13,13 @@
 #endif
 
 #include <QDateTime>
+#include <QHash>
 #include <QList>
 #include <QObject>
-#include <QTimer>
 
+#include <functional>
+
+#include "timerqueue.hpp"
 
 namespace QtMdns {
 
@@ -27,15 +34,183 @@ public:
     {
         Record record;
         QList<QDateTime> triggers;
+        bool observed;  // Added by observing responses, not by addRecord()
+        QDateTime added;
+        qsizetype size; // Memory counted toward the limit while observed
     };
 
     CachePrivate(Cache* cache) :
         QObject(cache),
-        q_ptr(cache)
+        q_ptr(cache),
+        timer([this]() { onTimeout(); })
     {
-        connect(&timer, &QTimer::timeout, this, &CachePrivate::onTimeout);
+        // Triggers already have a random offset, expirations can be late
+        timer.setSlack(100);
+    }
 
-        timer.setSingleShot(true);
+    QDateTime currentDateTime() const
+    {
+        return clock ? clock() : QDateTime::currentDateTime();
+    }
+
+    void scheduleTimer(QDateTime const& now)
+    {
+        // With an external clock the owner drives the timeouts
+        if ( ! clock)
+            timer.start(now.msecsTo(nextTrigger));
+    }
+
+    void insert(Record const& record, bool observed)
+    {
+        QDateTime const now = currentDateTime();
+
+        // If a record exists that matches, remove it from the cache; if the TTL
+        // is nonzero, it will be added back to the cache with updated times.
+        // A record with the cache-flush bit also replaces the other records of
+        // its name and type received more than a second ago, as a set of
+        // records may span several packets (RFC 6762 §10.2); goodbye records
+        // only remove themselves, NSEC records are always unique to their name
+        for (auto i = entries.begin(); i != entries.end();) {
+            bool const same = (*i).record == record;
+            bool const flushed = ! same && record.ttl() > 0
+                && (*i).record.domainName() == record.domainName()
+                && (*i).record.type() == record.type()
+                && (record.type() == NSEC || (record.flushCache() && (*i).added.msecsTo(now) > 1000));
+            if ( ! same && ! flushed) {
+                ++i;
+                continue;
+            }
+
+            // A record already cached by addRecord() stays renewed
+            if ( ! (*i).observed && same)
+                observed = false;
+            Record const removed = (*i).record;
+            i = erase(i);
+
+            // If the TTL is set to 0, indicate that the record was removed;
+            // no need to continue further
+            if (record.ttl() == 0) {
+                ++stats.expirations;
+                emit q_ptr->recordExpired(removed);
+                return;
+            }
+        }
+
+        // A goodbye for a record that is not cached, or no longer is as it
+        // was received twice (observed and added), has nothing to remove
+        if (record.ttl() == 0)
+            return;
+
+        // A record of a type that a cached NSEC record says does not exist
+        // makes the negative answer stale
+        if (record.type() != NSEC && isNegative(record.domainName(), record.type())) {
+            for (auto i = entries.begin(); i != entries.end(); ++i) {
+                if (i->record.type() == NSEC && i->record.domainName() == record.domainName()) {
+                    erase(i);
+                    break;
+                }
+            }
+        }
+
+        // Use the current time to calculate the triggers and add a random offset
+#ifdef USE_QRANDOMGENERATOR
+        qint64 const random = QRandomGenerator::global()->bounded(20);
+#else
+        qint64 const random = qrand() % 20;
+#endif
+
+        QList<QDateTime> triggers {
+            now.addMSecs(record.ttl() * 500 + random),  // 50%
+            now.addMSecs(record.ttl() * 850 + random),  // 85%
+            now.addMSecs(record.ttl() * 900 + random),  // 90%
+            now.addMSecs(record.ttl() * 950 + random),  // 95%
+            now.addSecs(record.ttl())
+        };
+
+        // Raw data shares the buffer of the packet it was received in; keep a
+        // copy of the data only rather than whole packets
+        Record entry = record;
+        if (RawRdata const* const raw = record.rdataAs<RawRdata>(); raw && raw->length != raw->packet.size())
+            entry.setRdata(RawRdata::fromByteArray(raw->toByteArray()));
+
+        // Append the record and its triggers
+        if (entry.type() == NSEC)
+            negatives.insert(entry.domainName(), entry.bitmap());
+        qsizetype const size = observed ? entrySize(entry) : 0;
+        entries.append({std::move(entry), triggers, observed, now, size});
+        ++stats.insertions;
+        if (observed) {
+            ++stats.observed;
+            observedBytes += size;
+        }
+
+        // Check if the new record's first trigger is earlier than the next
+        // scheduled trigger; if so, restart the timer
+        if (nextTrigger.isNull() || (triggers.at(0) < nextTrigger)) {
+            nextTrigger = triggers.at(0);
+            scheduleTimer(now);
+        }
+
+        while (observedBytes > observedLimit)
+            evictObserved();
+    }
+
+    // Estimate the memory used by an entry: its uncompressed wire format and
+    // the storage of the cache
+    static qsizetype entrySize(Record const& record)
+    {
+        QByteArray packet;
+        quint16 offset = 0;
+        QMap<QByteArray, quint16> nameMap;
+        writeRecord(packet, offset, record, nameMap);
+        return packet.size() + qsizetype(sizeof(Entry)) + 5 * qsizetype(sizeof(QDateTime));
+    }
+
+    // Drop the observed record closest to expiry; its consumers are told as
+    // they would be at expiry
+    void evictObserved()
+    {
+        auto victim = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->observed && (victim == entries.end() || it->triggers.last() < victim->triggers.last()))
+                victim = it;
+        }
+        if (victim != entries.end()) {
+            Record const record = victim->record;
+            erase(victim);
+            ++stats.evictions;
+            emit q_ptr->recordExpired(record);
+        }
+    }
+
+    // Remove an entry, keeping the memory of observed records and the negative
+    // answers in sync
+    QList<Entry>::iterator erase(QList<Entry>::iterator it)
+    {
+        if (it->observed)
+            observedBytes -= it->size;
+        if (it->record.type() == NSEC)
+            negatives.remove(it->record.domainName());
+        return entries.erase(it);
+    }
+
+    // A NSEC record for the name lists the types that exist, any other does not
+    bool isNegative(DomainName const& name, quint16 type) const
+    {
+        if (type == ANY || type == NSEC)
+            return false;
+        auto const it = negatives.constFind(name);
+        return it != negatives.constEnd() && ! it.value().contains(type);
+    }
+
+    void onMessageReceived(Message const& message)
+    {
+        if ( ! message.isResponse())
+            return;
+
+        QList<Record> const records = message.records();
+        for (Record const& record : records)
+            insert(record, true);
     }
 
     void onTimeout()
@@ -43,7 +218,7 @@ public:
         // Loop through all of the records in the cache, emitting the appropriate
         // signal when a trigger has passed, determining when the next trigger
         // will occur, and removing records that have expired
-        QDateTime const now = QDateTime::currentDateTime();
+        QDateTime const now = currentDateTime();
         QDateTime newNextTrigger;
 
         for (auto it = entries.begin(); it != entries.end();) {
@@ -65,13 +240,17 @@ public:
                 if (newNextTrigger.isNull() || it->triggers.at(0) < newNextTrigger)
                     newNextTrigger = it->triggers.at(0);
 
-                if (shouldQuery)
+                // Negative answers are not renewed, they are dropped at expiry
+                // and the next query asks again
+                if (shouldQuery && ! it->observed && it->record.type() != NSEC)
                     emit q_ptr->shouldQuery(it->record);
 
                 ++it;
             } else {
-                emit q_ptr->recordExpired(it->record);
-                it = entries.erase(it);
+                ++stats.expirations;
+                Record const record = it->record;
+                it = erase(it);
+                emit q_ptr->recordExpired(record);
             }
         }
 
@@ -79,13 +258,20 @@ public:
         // trigger and the timer should be started again
         nextTrigger = newNextTrigger;
         if ( ! nextTrigger.isNull())
-            timer.start(now.msecsTo(nextTrigger));
+            scheduleTimer(now);
     }
 
 private:
-    QTimer timer;
+    QueuedTimer timer;
+    std::function<QDateTime()> clock;
     QList<Entry> entries;
+    QHash<DomainName, Bitmap> negatives;  // Bitmaps of the cached NSEC records
     QDateTime nextTrigger;
+    mutable CacheStatistics stats;
+
+    QMetaObject::Connection observation;
+    qsizetype observedBytes {0};
+    qsizetype observedLimit {1024 * 1024};
 };
 
 
@@ -103,60 +289,62 @@ Cache::~Cache()
 void Cache::addRecord(const Record &record)
 {
     Q_D(Cache);
-    // If a record exists that matches, remove it from the cache; if the TTL
-    // is nonzero, it will be added back to the cache with updated times
-    for (auto i = d->entries.begin(); i != d->entries.end();) {
-        if ( (record.flushCache()
-              && (*i).record.name() == record.name()
-              && (*i).record.type() == record.type()
-             )
-            || (*i).record == record )
-        {
-
-            // If the TTL is set to 0, indicate that the record was removed
-            if (record.ttl() == 0)
-                emit recordExpired((*i).record);
-
-            i = d->entries.erase(i);
-
-            // No need to continue further if the TTL was set to 0
-            if (record.ttl() == 0)
-                return;
+    d->insert(record, false);
+}
 
-        } else {
-            ++i;
-        }
+void Cache::observe(AbstractServer* server)
+{
+    Q_D(Cache);
+    QObject::disconnect(d->observation);
+    if (server) {
+        d->observation = connect(server, &AbstractServer::messageReceived, d, &CachePrivate::onMessageReceived);
+        setTimerServer(server);
     }
+}
 
-    // Use the current time to calculate the triggers and add a random offset
-    QDateTime now = QDateTime::currentDateTime();
-#ifdef USE_QRANDOMGENERATOR
-    qint64 const random = QRandomGenerator::global()->bounded(20);
-#else
-    qint64 const random = qrand() % 20;
-#endif
-
-    QList<QDateTime> triggers {
-        now.addMSecs(record.ttl() * 500 + random),  // 50%
-        now.addMSecs(record.ttl() * 850 + random),  // 85%
-        now.addMSecs(record.ttl() * 900 + random),  // 90%
-        now.addMSecs(record.ttl() * 950 + random),  // 95%
-        now.addSecs(record.ttl())
-    };
+void Cache::setTimerServer(AbstractServer* server)
+{
+    Q_D(Cache);
+    d->timer.setServer(server);
+    if ( ! d->clock && ! d->nextTrigger.isNull())
+        d->scheduleTimer(QDateTime::currentDateTime());
+}
 
-    // Append the record and its triggers
-    d->entries.append({record, triggers});
+void Cache::setObservedMemoryLimit(qsizetype bytes)
+{
+    Q_D(Cache);
+    d->observedLimit = qMax<qsizetype>(0, bytes);
+    while (d->observedBytes > d->observedLimit)
+        d->evictObserved();
+}
 
-    // Check if the new record's first trigger is earlier than the next
-    // scheduled trigger; if so, restart the timer
-    if (d->nextTrigger.isNull() || (triggers.at(0) < d->nextTrigger)) {
-        d->nextTrigger = triggers.at(0);
-        d->timer.start(now.msecsTo(d->nextTrigger));
+void Cache::retainRecord(const Record &record)
+{
+    Q_D(Cache);
+    for (CachePrivate::Entry& entry : d->entries) {
+        if (entry.observed && entry.record == record) {
+            entry.observed = false;
+            d->observedBytes -= entry.size;
+            entry.size = 0;
+            return;
+        }
     }
 }
 
 bool Cache::lookupRecord(const QByteArray &name, quint16 type, Record &record) const
 {
+    return lookupRecord(DomainName(name), type, record);
+}
+
+bool Cache::lookupRecord(DomainName const& name, quint16 type, Record &record) const
+{
+    // A negative answer rules the record out without searching
+    Q_D(const Cache);
+    if (d->isNegative(name, type)) {
+        ++d->stats.negativeHits;
+        return false;
+    }
+
     QList<Record> records;
     if (lookupRecords(name, type, records)) {
         record = records.at(0);
@@ -166,18 +354,70 @@ bool Cache::lookupRecord(const QByteArray &name, quint16 type, Record &record) c
 }
 
 bool Cache::lookupRecords(const QByteArray &name, quint16 type, QList<Record> &records) const
+{
+    return lookupRecords(DomainName(name), type, records);
+}
+
+bool Cache::lookupRecords(DomainName const& name, quint16 type, QList<Record> &records) const
 {
     Q_D(const Cache);
     bool recordsAdded = false;
     for (CachePrivate::Entry const& entry : d->entries) {
-        if (   (name.isNull() || entry.record.name().endsWith(name))
+        if (   (name.isNull() || entry.record.domainName().endsWith(name))
             && (type == ANY || entry.record.type() == type) )
         {
             records.append(entry.record);
             recordsAdded = true;
         }
     }
+
+    if (recordsAdded)
+        ++d->stats.hits;
+    else
+        ++d->stats.misses;
     return recordsAdded;
 }
 
+bool Cache::isNegative(const QByteArray &name, quint16 type) const
+{
+    return isNegative(DomainName(name), type);
+}
+
+bool Cache::isNegative(DomainName const& name, quint16 type) const
+{
+    Q_D(const Cache);
+    return d->isNegative(name, type);
+}
+
+void Cache::setClock(std::function<QDateTime()> clock)
+{
+    Q_D(Cache);
+    d->clock = std::move(clock);
+    if (d->clock)
+        d->timer.stop();
+    else if ( ! d->nextTrigger.isNull())
+        d->scheduleTimer(QDateTime::currentDateTime());
+}
+
+void Cache::processTimeouts()
+{
+    Q_D(Cache);
+
+    // Scanning every record is only needed once a trigger has passed; the
+    // next trigger may be early after removals, never late
+    if (d->nextTrigger.isNull() || d->nextTrigger > d->currentDateTime())
+        return;
+
+    d->onTimeout();
+}
+
+CacheStatistics Cache::statistics() const
+{
+    Q_D(const Cache);
+    CacheStatistics stats = d->stats;
+    stats.records = d->entries.count();
+    stats.observedBytes = d->observedBytes;
+    return stats;
+}
+
 } // namespace QtMdns
@@ -1,5 +1,6 @@
 #include <qtmdns/bitmap.hpp>
 #include <qtmdns/dns.hpp>
+#include <qtmdns/domainname.hpp>
 #include <qtmdns/message.hpp>
 #include <qtmdns/query.hpp>
 #include <qtmdns/record.hpp>
@@ -7,12 +8,21 @@
 #include <QHostAddress>
 #include <QtEndian>
 
+#include <cstring>
+
 namespace QtMdns {
 
+// Offsets are 16 bits: bytes past 65535 are out of reach, which keeps
+// offset arithmetic from wrapping around
+static qsizetype packetEnd(QByteArray const& packet)
+{
+    return qMin<qsizetype>(packet.size(), 0xffff);
+}
+
 template<class T>
 bool parseInteger(QByteArray const& packet, quint16& offset, T &value)
 {
-    if (offset + sizeof(T) > static_cast<unsigned int>(packet.length()))
+    if (offset + sizeof(T) > static_cast<size_t>(packetEnd(packet)))
         return false;  // out-of-bounds
 
     value = qFromBigEndian<T>(reinterpret_cast<const uchar*>(packet.constData() + offset));
@@ -28,10 +38,23 @@ void writeInteger(QByteArray& packet, quint16& offset, T value)
     offset += sizeof(T);
 }
 
-bool parseName(QByteArray const& packet, quint16& offset, QByteArray &name)
+// Limits of RFC 1035: a name takes at most 255 bytes in wire format, so it
+// has at most 127 labels besides the root. Compression pointers add no
+// label, so a valid name never follows more pointers than it has labels.
+constexpr qsizetype MaxNameLength = 255;
+constexpr int MaxLabelCount = 128;
+constexpr int MaxPointerHops = MaxLabelCount;
+
+static bool parseName(QByteArray const& packet, quint16& offset, DomainName& name, ParseError& error)
 {
+    error = ParseError::InvalidName;
+
     quint16 offsetEnd = 0;
     quint16 offsetPtr = offset;
+    int labelCount = 0;
+    int pointerHops = 0;
+    char wire[MaxNameLength];
+    qsizetype wireLength = 0;
 
     forever {
         quint8 nBytes;
@@ -43,11 +66,18 @@ bool parseName(QByteArray const& packet, quint16& offset, QByteArray &name)
 
         switch (nBytes & 0xc0) {
         case 0x00:
-            if (offset + nBytes > packet.length())
+            if (offset + nBytes > packetEnd(packet))
                 return false;  // length exceeds message
 
-            name.append(packet.mid(offset, nBytes));
-            name.append('.');
+            // Keep room for the root label
+            if (++labelCount > MaxLabelCount || wireLength + 1 + nBytes + 1 > MaxNameLength) {
+                error = ParseError::NameTooLong;
+                return false;
+            }
+
+            wire[wireLength++] = static_cast<char>(nBytes);
+            std::memcpy(wire + wireLength, packet.constData() + offset, nBytes);
+            wireLength += nBytes;
             offset += nBytes;
             break;
 
@@ -59,8 +89,10 @@ bool parseName(QByteArray const& packet, quint16& offset, QByteArray &name)
                 return false;
 
             newOffset = ((nBytes & ~0xc0) << 8) | nBytes2;
-            if (newOffset >= offsetPtr)
-                return false;  // prevent infinite loop
+            if (newOffset >= offsetPtr || ++pointerHops > MaxPointerHops) {
+                error = ParseError::InvalidPointer;  // prevent loops and chains
+                return false;
+            }
 
             offsetPtr = newOffset;
             if ( ! offsetEnd)
@@ -78,43 +110,239 @@ bool parseName(QByteArray const& packet, quint16& offset, QByteArray &name)
     if (offsetEnd)
         offset = offsetEnd;
 
+    wire[wireLength++] = '\0';
+    name = DomainName::fromWireFormat(QByteArray(wire, wireLength));
+    if (name.isNull())
+        return false;
+
+    error = ParseError::NoError;
     return true;
 }
 
-void writeName(QByteArray& packet, quint16& offset, QByteArray const& name, QMap<QByteArray, quint16>& nameMap)
+bool parseName(QByteArray const& packet, quint16& offset, DomainName& name)
 {
-    QByteArray fragment = name;
-    if (fragment.endsWith('.'))
-        fragment.chop(1);
+    ParseError error;
+    return parseName(packet, offset, name, error);
+}
+
+bool parseName(QByteArray const& packet, quint16& offset, QByteArray &name)
+{
+    DomainName domainName;
+    if ( ! parseName(packet, offset, domainName))
+        return false;
 
-    while (fragment.length()) {
-        if (nameMap.contains(fragment)) {
-            writeInteger<quint16>(packet, offset, nameMap.value(fragment) | 0xc000);
+    name.append(domainName.toByteArray());
+    return true;
+}
+
+void writeName(QByteArray& packet, quint16& offset, DomainName const& name, QMap<QByteArray, quint16>& nameMap)
+{
+    // Each suffix of the wire format is a complete name, which can be pointed
+    // to if it was already written
+    QByteArray const wire = name.isNull() ? QByteArray(1, '\0') : name.toWireFormat();
+    qsizetype i = 0;
+    while (quint8 const length = static_cast<quint8>(wire.at(i))) {
+        QByteArray const suffix = QByteArray::fromRawData(wire.constData() + i, wire.size() - i);
+        auto const it = nameMap.constFind(suffix);
+        if (it != nameMap.constEnd()) {
+            writeInteger<quint16>(packet, offset, it.value() | 0xc000);
             return;
         }
 
-        nameMap.insert(fragment, offset);
-        int index = fragment.indexOf('.');
-        if (index == -1)
-            index = fragment.length();
+        // Pointers only have 14 bits
+        if (offset < 0x4000)
+            nameMap.insert(QByteArray(suffix.constData(), suffix.size()), offset);
 
-        writeInteger<quint8>(packet, offset, index);
-        packet.append(fragment.left(index));
-        offset += index;
-        fragment.remove(0, index + 1);
+        packet.append(wire.constData() + i, length + 1);
+        offset += length + 1;
+        i += length + 1;
     }
 
     writeInteger<quint8>(packet, offset, 0);
 }
 
-bool parseRecord(QByteArray const& packet, quint16& offset, Record& record)
+void writeName(QByteArray& packet, quint16& offset, QByteArray const& name, QMap<QByteArray, quint16>& nameMap)
 {
-    QByteArray name;
+    writeName(packet, offset, DomainName(name), nameMap);
+}
+
+// Type-specific rdata parsers: read the rdata of a record of the given type,
+// which ends at offset + length, and store it in the record
+template<quint16 Type>
+bool parseRdata(QByteArray const& packet, quint16& offset, quint16 length, Record& record);
+
+// Type-specific rdata writers: append the rdata of the record to data
+template<quint16 Type>
+void writeRdata(QByteArray& data, quint16& offset, Record const& record, QMap<QByteArray, quint16>& nameMap);
+
+template<>
+bool parseRdata<A>(QByteArray const& packet, quint16& offset, quint16 /*length*/, Record& record)
+{
+    quint32 ipv4Addr;
+    if ( ! parseInteger<quint32>(packet, offset, ipv4Addr))
+        return false;
+
+    record.setRdata(AddressRdata {QHostAddress(ipv4Addr)});
+    return true;
+}
+
+template<>
+void writeRdata<A>(QByteArray& data, quint16& offset, Record const& record, QMap<QByteArray, quint16>& /*nameMap*/)
+{
+    writeInteger<quint32>(data, offset, record.address().toIPv4Address());
+}
+
+template<>
+bool parseRdata<AAAA>(QByteArray const& packet, quint16& offset, quint16 /*length*/, Record& record)
+{
+    if (offset + 16 > packetEnd(packet))
+        return false;
+
+    record.setRdata(AddressRdata {QHostAddress(reinterpret_cast<const quint8*>(packet.constData() + offset))});
+    offset += 16;
+    return true;
+}
+
+template<>
+void writeRdata<AAAA>(QByteArray& data, quint16& offset, Record const& record, QMap<QByteArray, quint16>& /*nameMap*/)
+{
+    Q_IPV6ADDR const ipv6Addr = record.address().toIPv6Address();
+    data.append(reinterpret_cast<const char*>(&ipv6Addr), sizeof(Q_IPV6ADDR));
+    offset += sizeof(Q_IPV6ADDR);
+}
+
+template<>
+bool parseRdata<NSEC>(QByteArray const& packet, quint16& offset, quint16 dataLength, Record& record)
+{
+    NsecRdata rdata;
+    int const end = offset + dataLength;
+    if ( ! parseName(packet, offset, rdata.nextDomainName))
+        return false;
+
+    // Without any type, the window block is left out
+    if (offset == end) {
+        record.setRdata(std::move(rdata));
+        return true;
+    }
+
+    quint8 number;
+    quint8 length;
+    if (   ! parseInteger<quint8>(packet, offset, number)
+        || ! parseInteger<quint8>(packet, offset, length)
+        || (number != 0)
+        || (length > Bitmap::MaxLength)
+        || (offset + length > packetEnd(packet)) )
+    {
+        return false;
+    }
+
+    rdata.bitmap.setData(length, reinterpret_cast<const quint8*>(packet.constData() + offset));
+    offset += length;
+    record.setRdata(std::move(rdata));
+    return true;
+}
+
+template<>
+void writeRdata<NSEC>(QByteArray& data, quint16& offset, Record const& record, QMap<QByteArray, quint16>& nameMap)
+{
+    Bitmap const bitmap = record.bitmap();
+    quint8 const length = bitmap.length();
+    writeName(data, offset, DomainName(record.nextDomainName()), nameMap);
+    if (length == 0)
+        return;
+
+    writeInteger<quint8>(data, offset, 0);
+    writeInteger<quint8>(data, offset, length);
+    data.append(reinterpret_cast<const char*>(bitmap.data()), length);
+    offset += length;
+}
+
+template<>
+bool parseRdata<PTR>(QByteArray const& packet, quint16& offset, quint16 /*length*/, Record& record)
+{
+    PtrRdata rdata;
+    if ( ! parseName(packet, offset, rdata.target))
+        return false;
+
+    record.setRdata(std::move(rdata));
+    return true;
+}
+
+template<>
+void writeRdata<PTR>(QByteArray& data, quint16& offset, Record const& record, QMap<QByteArray, quint16>& nameMap)
+{
+    writeName(data, offset, record.targetName(), nameMap);
+}
+
+template<>
+bool parseRdata<SRV>(QByteArray const& packet, quint16& offset, quint16 /*length*/, Record& record)
+{
+    SrvRdata rdata;
+    if (   ! parseInteger<quint16>(packet, offset, rdata.priority)
+        || ! parseInteger<quint16>(packet, offset, rdata.weight)
+        || ! parseInteger<quint16>(packet, offset, rdata.port)
+        || ! parseName(packet, offset, rdata.target) )
+    {
+        return false;
+    }
+
+    record.setRdata(std::move(rdata));
+    return true;
+}
+
+template<>
+void writeRdata<SRV>(QByteArray& data, quint16& offset, Record const& record, QMap<QByteArray, quint16>& nameMap)
+{
+    writeInteger<quint16>(data, offset, record.priority());
+    writeInteger<quint16>(data, offset, record.weight());
+    writeInteger<quint16>(data, offset, record.port());
+    writeName(data, offset, record.targetName(), nameMap);
+}
+
+template<>
+bool parseRdata<TXT>(QByteArray const& packet, quint16& offset, quint16 length, Record& record)
+{
+    // The strings must exactly fill the rdata; they are kept as they are
+    int const end = offset + length;
+    int i = offset;
+    while (i < end)
+        i += 1 + static_cast<quint8>(packet.at(i));
+    if (i != end)
+        return false;
+
+    record.setRdata(TxtRdata {TxtData(QByteArray(packet.constData() + offset, length))});
+    offset += length;
+    return true;
+}
+
+template<>
+void writeRdata<TXT>(QByteArray& data, quint16& offset, Record const& record, QMap<QByteArray, quint16>& /*nameMap*/)
+{
+    TxtRdata const* const rdata = record.rdataAs<TxtRdata>();
+    QByteArray const& txt = rdata ? rdata->txt.toByteArray() : QByteArray();
+
+    // A TXT record holds at least one string, empty if there is no entry
+    if (txt.isEmpty()) {
+        writeInteger<quint8>(data, offset, 0);
+        return;
+    }
+
+    data.append(txt);
+    offset += txt.size();
+}
+
+
+static bool parseRecord(QByteArray const& packet, quint16& offset, Record& record, ParseError& error)
+{
+    DomainName name;
     quint16 type, class_, dataLen;
     quint32 ttl;
 
-    if (! parseName(packet, offset, name) ||
-        ! parseInteger<quint16>(packet, offset, type) ||
+    if ( ! parseName(packet, offset, name, error))
+        return false;
+
+    error = ParseError::InvalidRecord;
+    if (! parseInteger<quint16>(packet, offset, type) ||
         ! parseInteger<quint16>(packet, offset, class_) ||
         ! parseInteger<quint32>(packet, offset, ttl) ||
         ! parseInteger<quint16>(packet, offset, dataLen) )
@@ -122,176 +350,112 @@ bool parseRecord(QByteArray const& packet, quint16& offset, Record& record)
         return false;
     }
 
+    if (offset + dataLen > packetEnd(packet))
+        return false;
+
     record.setName(name);
     record.setType(type);
     record.setFlushCache(class_ & 0x8000);
     record.setTtl(ttl);
 
+    quint16 const end = offset + dataLen;
+    bool parsed = true;
     switch (type) {
-    case A:
-    {
-        quint32 ipv4Addr;
-        if ( ! parseInteger<quint32>(packet, offset, ipv4Addr))
-            return false;
-
-        record.setAddress(QHostAddress(ipv4Addr));
-        break;
-    }
-    case AAAA:
-    {
-        if (offset + 16 > packet.length())
-            return false;
-
-        record.setAddress(QHostAddress(
-            reinterpret_cast<const quint8*>(packet.constData() + offset)
-        ));
-        offset += 16;
-        break;
-    }
-    case NSEC:
-    {
-        QByteArray nextDomainName;
-        quint8 number;
-        quint8 length;
-        if (   ! parseName(packet, offset, nextDomainName)
-            || ! parseInteger<quint8>(packet, offset, number)
-            || ! parseInteger<quint8>(packet, offset, length)
-            || (number != 0)
-            || (offset + length > packet.length()) )
-        {
-            return false;
-        }
-
-        Bitmap bitmap;
-        bitmap.setData(length, reinterpret_cast<const quint8*>(packet.constData() + offset));
-        record.setNextDomainName(nextDomainName);
-        record.setBitmap(bitmap);
-        offset += length;
+    case A:    parsed = parseRdata<A>(packet, offset, dataLen, record); break;
+    case AAAA: parsed = parseRdata<AAAA>(packet, offset, dataLen, record); break;
+    case NSEC: parsed = parseRdata<NSEC>(packet, offset, dataLen, record); break;
+    case SRV:  parsed = parseRdata<SRV>(packet, offset, dataLen, record); break;
+    case TXT:  parsed = parseRdata<TXT>(packet, offset, dataLen, record); break;
+    // CNAME and NS data is a single, possibly compressed, name like PTR
+    case CNAME:
+    case NS:
+    case PTR:  parsed = parseRdata<PTR>(packet, offset, dataLen, record); break;
+    default:
+        // Keep the data of other types as a slice of the packet
+        record.setRdata(RawRdata {packet, offset, dataLen});
+        offset += dataLen;
         break;
     }
-    case PTR:
-    {
-        QByteArray target;
-        if ( ! parseName(packet, offset, target))
-            return false;
 
-        record.setTarget(target);
-        break;
-    }
-    case SRV:
-    {
-        quint16 priority, weight, port;
-        QByteArray target;
-        if (   ! parseInteger<quint16>(packet, offset, priority)
-            || ! parseInteger<quint16>(packet, offset, weight)
-            || ! parseInteger<quint16>(packet, offset, port)
-            || ! parseName(packet, offset, target) )
-        {
-            return false;
-        }
+    // The rdata must fit in its declared length; whatever a parser left
+    // unread is skipped
+    if ( ! parsed || offset > end)
+        return false;
+    offset = end;
 
-        record.setPriority(priority);
-        record.setWeight(weight);
-        record.setPort(port);
-        record.setTarget(target);
-        break;
-    }
-    case TXT:
-    {
-        quint16 start = offset;
-        while (offset < start + dataLen) {
-            quint8 nBytes;
-            if (   ! parseInteger<quint8>(packet, offset, nBytes)
-                || (offset + nBytes > packet.length()) )
-            {
-                return false;
-            }
+    error = ParseError::NoError;
+    return true;
+}
 
-            if (nBytes == 0)
-                break;
+bool parseRecord(QByteArray const& packet, quint16& offset, Record& record)
+{
+    ParseError error;
+    return parseRecord(packet, offset, record, error);
+}
 
-            QByteArray const attr(packet.constData() + offset, nBytes);
-            offset += nBytes;
-            qsizetype const splitIndex = attr.indexOf('=');
-            if (splitIndex == -1)
-                record.addAttribute(attr, QByteArray());
-            else
-                record.addAttribute(attr.left(splitIndex), attr.mid(splitIndex + 1));
-        }
-        break;
+static void writeRecordData(QByteArray& data, quint16& offset, Record const& record, QMap<QByteArray, quint16>& nameMap)
+{
+    if (RawRdata const* const raw = record.rdataAs<RawRdata>()) {
+        // Re-emit raw data as received, whatever the type
+        data.append(raw->constData(), raw->length);
+        offset += raw->length;
+        return;
     }
 
-    default:
-        offset += dataLen;
-        break;
+    switch (record.type()) {
+    case A:    writeRdata<A>(data, offset, record, nameMap); break;
+    case AAAA: writeRdata<AAAA>(data, offset, record, nameMap); break;
+    case NSEC: writeRdata<NSEC>(data, offset, record, nameMap); break;
+    case SRV:  writeRdata<SRV>(data, offset, record, nameMap); break;
+    case TXT:  writeRdata<TXT>(data, offset, record, nameMap); break;
+    case CNAME:
+    case NS:
+    case PTR:  writeRdata<PTR>(data, offset, record, nameMap); break;
+    default:   break;
     }
-    return true;
 }
 
 void writeRecord(QByteArray& packet, quint16& offset, Record const& record, QMap<QByteArray, quint16>& nameMap)
 {
-    writeName(packet, offset, record.name(), nameMap);
+    writeName(packet, offset, record.domainName(), nameMap);
     writeInteger<quint16>(packet, offset, record.type());
     writeInteger<quint16>(packet, offset, record.flushCache() ? 0x8001 : 1);
     writeInteger<quint32>(packet, offset, record.ttl());
 
     offset += 2;
     QByteArray data;
-    switch (record.type()) {
-    case A:
-        writeInteger<quint32>(data, offset, record.address().toIPv4Address());
-        break;
-    case AAAA:
-    {
-        Q_IPV6ADDR const ipv6Addr = record.address().toIPv6Address();
-        data.append(reinterpret_cast<const char*>(&ipv6Addr), sizeof(Q_IPV6ADDR));
-        offset += data.length();
-        break;
-    }
-    case NSEC:
-    {
-        quint8 const length = record.bitmap().length();
-        writeName(data, offset, record.nextDomainName(), nameMap);
-        writeInteger<quint8>(data, offset, 0);
-        writeInteger<quint8>(data, offset, length);
-        data.append(reinterpret_cast<const char*>(record.bitmap().data()), length);
-        offset += length;
-        break;
-    }
-    case PTR:
-        writeName(data, offset, record.target(), nameMap);
-        break;
-    case SRV:
-        writeInteger<quint16>(data, offset, record.priority());
-        writeInteger<quint16>(data, offset, record.weight());
-        writeInteger<quint16>(data, offset, record.port());
-        writeName(data, offset, record.target(), nameMap);
-        break;
-    case TXT:
-        if (!record.attributes().count()) {
-            writeInteger<quint8>(data, offset, 0);
-            break;
-        }
-
-        for (auto i = record.attributes().constBegin(); i != record.attributes().constEnd(); ++i) {
-            QByteArray const entry = i.value().isNull() ? i.key() : i.key() + "=" + i.value();
-            writeInteger<quint8>(data, offset, entry.length());
-            data.append(entry);
-            offset += entry.length();
-        }
-        break;
-
-    default:
-        break;
-    }
+    writeRecordData(data, offset, record, nameMap);
 
     offset -= 2;
     writeInteger<quint16>(packet, offset, data.length());
     packet.append(data);
 }
 
+QByteArray rdataToWireFormat(Record const& record)
+{
+    // Rdata holds at most one name, which has nothing to point to in an
+    // empty name map
+    QByteArray data;
+    quint16 offset = 0;
+    QMap<QByteArray, quint16> nameMap;
+    writeRecordData(data, offset, record, nameMap);
+    return data;
+}
+
 bool fromPacket(QByteArray const& packet, Message& message)
 {
+    ParseError error;
+    return fromPacket(packet, message, error);
+}
+
+bool fromPacket(QByteArray const& packet, Message& message, ParseError& error)
+{
+    // Offsets are 16 bits, as are compression pointers
+    if (packet.size() > 0xffff) {
+        error = ParseError::PacketTooLarge;
+        return false;
+    }
+
     quint16 offset = 0;
     quint16 transactionId, flags, nQuestion, nAnswer, nAuthority, nAdditional;
     if (! parseInteger<quint16>(packet, offset, transactionId) ||
@@ -301,19 +465,27 @@ bool fromPacket(QByteArray const& packet, Message& message)
         ! parseInteger<quint16>(packet, offset, nAuthority) ||
         ! parseInteger<quint16>(packet, offset, nAdditional) )
     {
+        error = ParseError::TruncatedHeader;
         return false;
     }
 
     message.setTransactionId(transactionId);
     message.setResponse(flags & 0x8400);
     message.setTruncated(flags & 0x0200);
+
+    // Counts come from the packet, only trust them as far as the packet
+    // could actually hold that many entries (a question takes at least 5
+    // bytes, a record at least 11)
+    message.reserve(qMin<qsizetype>(nQuestion, (packet.size() - offset) / 5), 0);
     for (int i = 0; i < nQuestion; ++i) {
-        QByteArray name;
+        DomainName name;
         quint16 type, class_;
-        if (! parseName(packet, offset, name) ||
-            ! parseInteger<quint16>(packet, offset, type) ||
+        if ( ! parseName(packet, offset, name, error))
+            return false;
+        if (! parseInteger<quint16>(packet, offset, type) ||
             ! parseInteger<quint16>(packet, offset, class_) )
         {
+            error = ParseError::InvalidQuery;
             return false;
         }
 
@@ -321,18 +493,24 @@ bool fromPacket(QByteArray const& packet, Message& message)
             query.setName(name);
             query.setType(type);
             query.setUnicastResponse(class_ & 0x8000);
-        message.addQuery(query);
+        message.addQuery(std::move(query));
     }
 
-    quint16 const nRecord = nAnswer + nAuthority + nAdditional;
-    for (quint16 i = 0; i < nRecord; ++i) {
+    int const nRecord = nAnswer + nAuthority + nAdditional;
+    message.reserve(0, qMin<qsizetype>(nRecord, (packet.size() - offset) / 11));
+    for (int i = 0; i < nRecord; ++i) {
         Record record;
-        if ( ! parseRecord(packet, offset, record)) {
+        if ( ! parseRecord(packet, offset, record, error)) {
             return false;
         }
 
-        message.addRecord(record);
+        Message::Section const section = i < nAnswer ? Message::Answer
+                                       : i < nAnswer + nAuthority ? Message::Authority
+                                       : Message::Additional;
+        message.addRecord(std::move(record), section);
     }
+
+    error = ParseError::NoError;
     return true;
 }
 
@@ -345,14 +523,14 @@ QByteArray toPacket(Message const& message)
     writeInteger<quint16>(packet, offset, message.transactionId());
     writeInteger<quint16>(packet, offset, flags);
     writeInteger<quint16>(packet, offset, static_cast<quint16>(message.queries().length()));
-    writeInteger<quint16>(packet, offset, static_cast<quint16>(message.records().length()));
-    writeInteger<quint16>(packet, offset, 0);
-    writeInteger<quint16>(packet, offset, 0);
+    writeInteger<quint16>(packet, offset, static_cast<quint16>(message.records(Message::Answer).length()));
+    writeInteger<quint16>(packet, offset, static_cast<quint16>(message.records(Message::Authority).length()));
+    writeInteger<quint16>(packet, offset, static_cast<quint16>(message.records(Message::Additional).length()));
 
     QMap<QByteArray, quint16> nameMap;
     QList<Query> const& queries = message.queries();
     for (Query const& query : queries) {
-        writeName(packet, offset, query.name(), nameMap);
+        writeName(packet, offset, query.domainName(), nameMap);
         writeInteger<quint16>(packet, offset, query.type());
         writeInteger<quint16>(packet, offset, query.unicastResponse() ? 0x8001 : 1);
     }
@@ -364,12 +542,114 @@ QByteArray toPacket(Message const& message)
     return packet;
 }
 
+QList<Message> splitMessage(Message const& message, quint16 maxSize)
+{
+    // Queries with the authority records of their name are kept together,
+    // any other record is added on its own
+    struct Unit
+    {
+        QList<Query> queries;
+        QList<std::pair<Record, Message::Section>> records;
+    };
+
+    QList<Unit> units;
+    QList<Record> authority = message.records(Message::Authority);
+    QList<Query> const queries = message.queries();
+    for (Query const& query : queries) {
+        Unit unit {{query}, {}};
+        for (auto it = authority.begin(); it != authority.end();) {
+            if (it->domainName() == query.domainName()) {
+                unit.records.append({*it, Message::Authority});
+                it = authority.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        units.append(std::move(unit));
+    }
+    for (Message::Section const section : {Message::Answer, Message::Authority, Message::Additional}) {
+        const auto records = section == Message::Authority ? authority : message.records(section);
+        for (Record const& record : records)
+            units.append({{}, {{record, section}}});
+    }
+
+    auto const newMessage = [&message]() {
+        Message part;
+        part.setAddress(message.address());
+        part.setPort(message.port());
+        part.setTransactionId(message.transactionId());
+        part.setResponse(message.isResponse());
+        part.setTruncated(message.isTruncated());
+        return part;
+    };
+
+    // Encode the units as toPacket() would, after the header, to know where
+    // the message has to be split
+    quint16 const headerSize = 12;
+    QByteArray packet;
+    quint16 offset = headerSize;
+    QMap<QByteArray, quint16> nameMap;
+    auto const encode = [&](Unit const& unit) {
+        for (Query const& query : unit.queries) {
+            writeName(packet, offset, query.domainName(), nameMap);
+            offset += 4;
+        }
+        for (auto const& record : unit.records)
+            writeRecord(packet, offset, record.first, nameMap);
+    };
+
+    QList<Message> messages;
+    Message part = newMessage();
+    bool empty = true;
+    for (Unit const& unit : qAsConst(units)) {
+        encode(unit);
+        if (offset > maxSize && ! empty) {
+            messages.append(std::move(part));
+            part = newMessage();
+            empty = true;
+
+            packet.clear();
+            offset = headerSize;
+            nameMap.clear();
+            encode(unit);
+        }
+
+        for (Query const& query : unit.queries)
+            part.addQuery(query);
+        for (auto const& record : unit.records)
+            part.addRecord(record.first, record.second);
+        empty = false;
+    }
+    if ( ! empty)
+        messages.append(std::move(part));
+    return messages;
+}
+
+Record nsecRecord(DomainName const& name, QList<quint16> const& types, quint32 ttl)
+{
+    // Only the first window block is used in mDNS
+    Bitmap bitmap;
+    for (quint16 const type : types)
+        bitmap.insert(type);
+
+    Record record;
+    record.setName(name);
+    record.setType(NSEC);
+    record.setFlushCache(true);
+    record.setTtl(ttl);
+    record.setNextDomainName(name.toByteArray());
+    record.setBitmap(bitmap);
+    return record;
+}
+
 QString typeName(quint16 type)
 {
     switch (type) {
     case A:    return "A";
     case AAAA: return "AAAA";
     case ANY:  return "ANY";
+    case CNAME: return "CNAME";
+    case NS:   return "NS";
     case NSEC: return "NSEC";
     case PTR:  return "PTR";
     case SRV:  return "SRV";
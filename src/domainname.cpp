@@ -0,0 +1,408 @@
+#include <qtmdns/domainname.hpp>
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <atomic>
+#include <vector>
+
+namespace QtMdns {
+
+struct DomainNameData
+{
+    QByteArray wire;                // Length-prefixed labels, ending with the root label
+    QByteArray dotted;              // Escaped dotted form
+    std::vector<quint8> labels;     // Offset in wire of the length byte of each label
+    size_t hash {0};                // Hash of the case-folded name
+    DomainNameData* folded {nullptr};  // Entry of the case-folded name, this if already folded
+    DomainNameData* parent {nullptr};  // Entry of the name without its first label, null for the root
+    std::atomic<int> ref {0};
+};
+
+namespace {
+
+constexpr qsizetype MaxLabelLength = 63;
+constexpr qsizetype MaxNameLength = 255;
+
+struct InternTable
+{
+    QMutex mutex;
+    QHash<QByteArray, DomainNameData*> names;  // Indexed by wire format
+};
+
+InternTable& internTable()
+{
+    static InternTable table;
+    return table;
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+char foldCase(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// Length bytes are at most 63 and cannot be mistaken for letters, so the wire
+// format can be folded as a whole
+QByteArray foldCase(QByteArray const& wire)
+{
+    qsizetype i = 0;
+    while (i < wire.size() && foldCase(wire.at(i)) == wire.at(i))
+        ++i;
+    if (i == wire.size())
+        return wire;
+
+    QByteArray folded = wire;
+    char* const data = folded.data();
+    for (; i < folded.size(); ++i)
+        data[i] = foldCase(data[i]);
+    return folded;
+}
+
+bool isValidWireFormat(QByteArray const& wire)
+{
+    if (wire.isEmpty() || wire.size() > MaxNameLength)
+        return false;
+
+    qsizetype i = 0;
+    forever {
+        quint8 const length = static_cast<quint8>(wire.at(i));
+        if (length == 0)
+            return i + 1 == wire.size();
+        if (length > MaxLabelLength)
+            return false;
+        i += length + 1;
+        if (i >= wire.size())
+            return false;
+    }
+}
+
+bool appendLabel(QByteArray& wire, QByteArray const& label)
+{
+    if (label.isEmpty() || label.size() > MaxLabelLength)
+        return false;
+    wire.append(static_cast<char>(label.size()));
+    wire.append(label);
+    return true;
+}
+
+QByteArray escapedDottedForm(QByteArray const& wire)
+{
+    if (wire.size() == 1)
+        return QByteArray(".");
+
+    QByteArray dotted;
+    dotted.reserve(wire.size());
+    qsizetype i = 0;
+    while (quint8 const length = static_cast<quint8>(wire.at(i))) {
+        for (qsizetype j = i + 1; j <= i + length; ++j) {
+            char const c = wire.at(j);
+            if (c == '.' || c == '\\')
+                dotted.append('\\');
+            dotted.append(c);
+        }
+        dotted.append('.');
+        i += length + 1;
+    }
+    return dotted;
+}
+
+// Caller holds the table mutex, wire is valid; returns the entry with a new
+// reference
+DomainNameData* intern(InternTable& table, QByteArray const& wire)
+{
+    auto const it = table.names.constFind(wire);
+    if (it != table.names.constEnd()) {
+        it.value()->ref.fetch_add(1, std::memory_order_relaxed);
+        return it.value();
+    }
+
+    DomainNameData* const data = new DomainNameData;
+    data->wire = wire;
+    data->dotted = escapedDottedForm(wire);
+    data->ref.store(1, std::memory_order_relaxed);
+
+    for (qsizetype i = 0; wire.at(i); i += static_cast<quint8>(wire.at(i)) + 1)
+        data->labels.push_back(static_cast<quint8>(i));
+
+    QByteArray const folded = foldCase(wire);
+    if (folded == wire) {
+        data->folded = data;
+        data->hash = qHash(wire);
+    } else {
+        data->folded = intern(table, folded);
+        data->hash = data->folded->hash;
+    }
+
+    if ( ! data->labels.empty())
+        data->parent = intern(table, wire.mid(static_cast<quint8>(wire.at(0)) + 1));
+
+    table.names.insert(data->wire, data);
+    return data;
+}
+
+DomainNameData* intern(QByteArray const& wire)
+{
+    InternTable& table = internTable();
+    QMutexLocker locker(&table.mutex);
+    return intern(table, wire);
+}
+
+void release(DomainNameData* data)
+{
+    // Only the last reference needs the table: a name can be found again
+    // while its count drops to zero, so that last decrement happens under
+    // the mutex
+    int ref = data->ref.load(std::memory_order_relaxed);
+    while (ref > 1) {
+        if (data->ref.compare_exchange_weak(ref, ref - 1, std::memory_order_acq_rel))
+            return;
+    }
+
+    DomainNameData* folded = nullptr;
+    DomainNameData* parent = nullptr;
+    {
+        InternTable& table = internTable();
+        QMutexLocker locker(&table.mutex);
+        if (data->ref.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        table.names.remove(data->wire);
+        if (data->folded != data)
+            folded = data->folded;
+        parent = data->parent;
+        delete data;
+    }
+
+    if (folded)
+        release(folded);
+    if (parent)
+        release(parent);
+}
+
+} // namespace
+
+
+DomainName::DomainName(DomainNameData* data) :
+    d(data)
+{
+}
+
+DomainName::DomainName(QByteArray const& name)
+{
+    if (name.isNull())
+        return;
+
+    QByteArray wire;
+    QByteArray label;
+    wire.reserve(name.size() + 2);
+
+    qsizetype const size = name.size();
+    for (qsizetype i = 0; i < size; ++i) {
+        char const c = name.at(i);
+        if (c == '\\' && i + 1 < size) {
+            // Decimal "\DDD" or escaped character
+            if (i + 3 < size && isDigit(name.at(i + 1)) && isDigit(name.at(i + 2)) && isDigit(name.at(i + 3))) {
+                int const value = name.mid(i + 1, 3).toInt();
+                if (value > 255)
+                    return;
+                label.append(static_cast<char>(value));
+                i += 3;
+            } else {
+                label.append(name.at(++i));
+            }
+        } else if (c == '.') {
+            // A lone dot is the root
+            if (label.isEmpty() && size == 1)
+                break;
+            if ( ! appendLabel(wire, label))
+                return;
+            label.clear();
+        } else {
+            label.append(c);
+        }
+    }
+
+    if ( ! label.isEmpty() && ! appendLabel(wire, label))
+        return;
+    wire.append('\0');
+
+    if (wire.size() <= MaxNameLength)
+        d = intern(wire);
+}
+
+DomainName::DomainName(DomainName const& other) :
+    d(other.d)
+{
+    if (d)
+        d->ref.fetch_add(1, std::memory_order_relaxed);
+}
+
+DomainName::DomainName(DomainName&& other) noexcept :
+    d(other.d)
+{
+    other.d = nullptr;
+}
+
+DomainName& DomainName::operator=(DomainName const& other)
+{
+    if (other.d)
+        other.d->ref.fetch_add(1, std::memory_order_relaxed);
+    if (d)
+        release(d);
+    d = other.d;
+    return *this;
+}
+
+DomainName& DomainName::operator=(DomainName&& other) noexcept
+{
+    std::swap(d, other.d);
+    return *this;
+}
+
+DomainName::~DomainName()
+{
+    if (d)
+        release(d);
+}
+
+
+DomainName DomainName::fromLabels(QList<QByteArray> const& labels)
+{
+    QByteArray wire;
+    for (QByteArray const& label : labels) {
+        if ( ! appendLabel(wire, label))
+            return DomainName();
+    }
+    wire.append('\0');
+
+    if (wire.size() > MaxNameLength)
+        return DomainName();
+    return DomainName(intern(wire));
+}
+
+DomainName DomainName::fromWireFormat(QByteArray const& wire)
+{
+    if ( ! isValidWireFormat(wire))
+        return DomainName();
+    return DomainName(intern(wire));
+}
+
+
+bool DomainName::operator==(DomainName const& other) const
+{
+    if ( ! d || ! other.d)
+        return d == other.d;
+    return d->folded == other.d->folded;
+}
+
+bool DomainName::operator!=(DomainName const& other) const
+{
+    return !(*this == other);
+}
+
+bool DomainName::isNull() const
+{
+    return !d;
+}
+
+bool DomainName::isRoot() const
+{
+    return d && d->labels.empty();
+}
+
+QByteArray DomainName::toByteArray() const
+{
+    return d ? d->dotted : QByteArray();
+}
+
+QByteArray DomainName::toWireFormat() const
+{
+    return d ? d->wire : QByteArray();
+}
+
+size_t DomainName::hash() const
+{
+    return d ? d->hash : 0;
+}
+
+int DomainName::labelCount() const
+{
+    return d ? static_cast<int>(d->labels.size()) : 0;
+}
+
+QByteArray DomainName::label(int index) const
+{
+    if (index < 0 || index >= labelCount())
+        return QByteArray();
+
+    qsizetype const offset = d->labels[index];
+    return d->wire.mid(offset + 1, static_cast<quint8>(d->wire.at(offset)));
+}
+
+QList<QByteArray> DomainName::labels() const
+{
+    QList<QByteArray> labels;
+    labels.reserve(labelCount());
+    for (int i = 0; i < labelCount(); ++i)
+        labels.append(label(i));
+    return labels;
+}
+
+DomainName DomainName::parent() const
+{
+    if ( ! d || ! d->parent)
+        return DomainName();
+
+    d->parent->ref.fetch_add(1, std::memory_order_relaxed);
+    return DomainName(d->parent);
+}
+
+DomainName DomainName::child(QByteArray const& label) const
+{
+    if ( ! d)
+        return DomainName();
+
+    QByteArray wire;
+    if ( ! appendLabel(wire, label))
+        return DomainName();
+    wire.append(d->wire);
+
+    if (wire.size() > MaxNameLength)
+        return DomainName();
+    return DomainName(intern(wire));
+}
+
+bool DomainName::endsWith(DomainName const& suffix) const
+{
+    if ( ! d || ! suffix.d)
+        return false;
+
+    // Parents of a folded entry are folded too
+    DomainNameData const* const target = suffix.d->folded;
+    for (DomainNameData const* entry = d->folded; entry; entry = entry->parent) {
+        if (entry == target)
+            return true;
+    }
+    return false;
+}
+
+qsizetype DomainName::internedCount()
+{
+    InternTable& table = internTable();
+    QMutexLocker locker(&table.mutex);
+    return table.names.size();
+}
+
+
+size_t qHash(DomainName const& name, size_t seed)
+{
+    return name.hash() ^ seed;
+}
+
+} // namespace QtMdns
@@ -0,0 +1,91 @@
+#include <qtmdns/abstractserver.hpp>
+#include <qtmdns/browser.hpp>
+#include <qtmdns/cache.hpp>
+#include <qtmdns/futures.hpp>
+#include <qtmdns/prober.hpp>
+#include <qtmdns/record.hpp>
+
+#if(QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+
+#include <QPointer>
+#include <QPromise>
+
+#include "timerqueue.hpp"
+
+namespace QtMdns {
+
+QFuture<QList<Service>> browseAsync(AbstractServer* server, const QByteArray &type, int count,
+                                    int timeout, std::shared_ptr<Cache> cache)
+{
+    // The browser is owned by the server, so that the operation ends with it
+    struct State
+    {
+        QPromise<QList<Service>> promise;
+        QList<Service> services;
+        Browser* browser {nullptr};
+        QPointer<TimerQueue> timers;
+        TimerQueue::Id timeout {0};
+        bool finished {false};
+
+        void finish()
+        {
+            if (finished)
+                return;
+            finished = true;
+            promise.addResult(services);
+            promise.finish();
+            browser->deleteLater();
+            if (timers)
+                timers->cancel(timeout);
+        }
+    };
+
+    auto const state = std::make_shared<State>();
+    state->promise.start();
+    state->browser = new Browser(server, type, std::move(cache), server);
+    state->timers = TimerQueue::instance(server);
+
+    QObject::connect(state->browser, &Browser::serviceAdded, state->browser,
+                     [state, count](const Service &service) {
+        state->services.append(service);
+        if ((count > 0 && state->services.size() >= count) || state->promise.isCanceled())
+            state->finish();
+    });
+    state->timeout = state->timers->schedule(timeout, 100, [state]() { state->finish(); });
+
+    return state->promise.future();
+}
+
+QFuture<ResolveResult> resolveAsync(AbstractServer* server, const QList<QByteArray> &names,
+                                    int timeout, std::shared_ptr<Cache> cache)
+{
+    auto const promise = std::make_shared<QPromise<ResolveResult>>();
+    promise->start();
+
+    Resolver::resolve(server, names, timeout, [promise](const ResolveResult &result) {
+        promise->addResult(result);
+        promise->finish();
+    }, std::move(cache));
+
+    return promise->future();
+}
+
+QFuture<QByteArray> probeAsync(AbstractServer* server, const Record &record)
+{
+    auto const promise = std::make_shared<QPromise<QByteArray>>();
+    promise->start();
+
+    // The prober is owned by the server, so that the operation ends with it
+    Prober* const prober = new Prober(server, record, server);
+    QObject::connect(prober, &Prober::nameConfirmed, prober, [promise, prober](const QByteArray &name) {
+        promise->addResult(name);
+        promise->finish();
+        prober->deleteLater();
+    });
+
+    return promise->future();
+}
+
+} // namespace QtMdns
+
+#endif
@@ -1,5 +1,6 @@
 #include <qtmdns/abstractserver.hpp>
 #include <qtmdns/dns.hpp>
+#include <qtmdns/domainname.hpp>
 #include <qtmdns/hostname.hpp>
 #include <qtmdns/message.hpp>
 #include <qtmdns/query.hpp>
@@ -11,7 +12,11 @@
 #include <QNetworkInterface>
 #include <QObject>
 #include <QPointer>
-#include <QTimer>
+
+#include <algorithm>
+
+#include "announcer.hpp"
+#include "timerqueue.hpp"
 
 namespace QtMdns {
 
@@ -25,28 +30,35 @@ public:
     HostnamePrivate(Hostname* hostname, AbstractServer* server, QByteArray wantedName) :
         q_ptr(hostname),
         server(server),
-        wantedHostname(std::move(wantedName))
+        wantedHostname(std::move(wantedName)),
+        registrationTimer([this]() { onRegistrationTimeout(); }),
+        rebroadcastTimer([this]() { onRebroadcastTimeout(); })
     {
         QObject::connect(server, &AbstractServer::messageReceived, hostname,
                          [&](Message const& message) { onMessageReceived(message); });
-        QObject::connect(&registrationTimer, &QTimer::timeout, hostname,
-                         [&]() { onRegistrationTimeout(); });
-        QObject::connect(&rebroadcastTimer, &QTimer::timeout, hostname,
-                         [&]() { onRebroadcastTimeout(); });
 
         if (qsizetype const idx = wantedHostname.lastIndexOf(".local"); idx > 0)
             wantedHostname.truncate(idx);
 
+        registrationTimer.setServer(server);
         registrationTimer.setInterval(2 * 1000);
-        registrationTimer.setSingleShot(true);
+        registrationTimer.setSlack(100);
 
+        rebroadcastTimer.setServer(server);
         rebroadcastTimer.setInterval(30 * 60 * 1000);
-        rebroadcastTimer.setSingleShot(true);
+        rebroadcastTimer.setSlack(60 * 1000);
 
         // Immediately assert the hostname
         onRebroadcastTimeout();
     }
 
+    ~HostnamePrivate()
+    {
+        // Remove the addresses from the caches of peers
+        if (server)
+            Announcer::instance(server)->withdraw(q_ptr);
+    }
+
     void assertHostname()
     {
         // Begin with the local hostname and replace any "." with "-" (I'm looking
@@ -61,6 +73,7 @@ public:
         hostname = (hostnameSuffix == 1
                     ? localHostname
                     : localHostname + "-" + QByteArray::number(hostnameSuffix)) + ".local.";
+        hostnameName = DomainName(hostname);
 
         // Compose a query for A and AAAA records matching the hostname
         Query ipv4Query;
@@ -81,7 +94,7 @@ public:
         registrationTimer.start();
     }
 
-    std::optional<Record> generateRecord(QHostAddress const& srcAddress, quint16 type)
+    std::optional<Record> generateRecord(QHostAddress const& srcAddress, quint16 type) const
     {
         // Attempt to find the interface that corresponds with the provided
         // address and determine this device's address from the interface
@@ -109,6 +122,80 @@ public:
         return std::nullopt;
     }
 
+    QList<Record> addressRecords(QHostAddress const& peer) const
+    {
+        QList<Record> records;
+        for (quint16 const type : {A, AAAA}) {
+            if (auto record = generateRecord(peer, type); record)
+                records.append(std::move(*record));
+        }
+        return records;
+    }
+
+    // Add the addresses of the hostname that are not answers to the
+    // additional section, with a NSEC record when a family has none or a
+    // negative answer is due; without other answers, the NSEC record is the
+    // answer
+    void addAdditionalRecords(Message& reply, QHostAddress const& peer, bool negative)
+    {
+        // Without an address on the network of the peer, it is unknown
+        // which records the host has there
+        const auto records = addressRecords(peer);
+        if (records.isEmpty())
+            return;
+
+        QList<Record> const answers = reply.records(Message::Answer);
+        QList<quint16> types;
+        for (Record const& record : records) {
+            types.append(record.type());
+            if ( ! answers.contains(record))
+                reply.addRecord(record, Message::Additional);
+        }
+        if (types.size() < 2 || negative) {
+            reply.addRecord(nsecRecord(hostnameName, types, records.first().ttl()),
+                            answers.isEmpty() ? Message::Answer : Message::Additional);
+        }
+    }
+
+    // Addresses are compared without their scope, which is not sent
+    static bool isSameAddress(QHostAddress const& a, QHostAddress const& b)
+    {
+        if (a.protocol() != b.protocol())
+            return false;
+        if (a.protocol() == QAbstractSocket::IPv4Protocol)
+            return a.toIPv4Address() == b.toIPv4Address();
+
+        Q_IPV6ADDR const addressA = a.toIPv6Address();
+        Q_IPV6ADDR const addressB = b.toIPv6Address();
+        return std::equal(addressA.c, addressA.c + 16, addressB.c);
+    }
+
+    QList<Record> generateAllRecords()
+    {
+        // Addresses of all the interfaces mDNS can be used on
+        QList<Record> records;
+        const auto interfaces = QNetworkInterface::allInterfaces();
+        for (QNetworkInterface const& networkInterface : interfaces) {
+            auto const flags = networkInterface.flags();
+            if ( ! (flags & QNetworkInterface::IsUp) || ! (flags & QNetworkInterface::CanMulticast)
+                 || (flags & QNetworkInterface::IsLoopBack) )
+            {
+                continue;
+            }
+
+            const auto entries = networkInterface.addressEntries();
+            for (QNetworkAddressEntry const& entry : entries) {
+                QHostAddress const address = entry.ip();
+                Record record;
+                record.setName(hostnameName);
+                record.setType(address.protocol() == QAbstractSocket::IPv6Protocol ? AAAA : A);
+                record.setAddress(address);
+                records.append(record);
+            }
+        }
+        return records;
+    }
+
 
     void onMessageReceived(Message const& message)
     {
@@ -116,9 +203,20 @@ public:
             if (hostnameRegistered)
                 return;
 
+            // Only different data for the name is a conflict (RFC 6762 §9):
+            // the server also receives the addresses it sent itself
+            QList<Record> ownRecords;
             const auto records = message.records();
             for (const Record &record : records) {
-                if ((record.type() == A || record.type() == AAAA) && record.name() == hostname) {
+                if ((record.type() != A && record.type() != AAAA) || record.domainName() != hostnameName)
+                    continue;
+
+                if (ownRecords.isEmpty())
+                    ownRecords = generateAllRecords();
+                bool const own = std::any_of(ownRecords.cbegin(), ownRecords.cend(), [&record](Record const& ownRecord) {
+                    return ownRecord.type() == record.type() && isSameAddress(ownRecord.address(), record.address());
+                });
+                if ( ! own) {
                     ++hostnameSuffix;
                     assertHostname();
                 }
@@ -133,13 +231,34 @@ public:
             const auto queries = message.queries();
             reply.addQueries(queries);
 
+            // Queries for records the host does not have get a negative
+            // answer (RFC 6762 §6.1)
+            bool queried = false;
+            bool negative = false;
             for (Query const& query : queries) {
-                if ((query.type() == A || query.type() == AAAA) && query.name() == hostname) {
+                if (query.domainName() != hostnameName)
+                    continue;
+
+                queried = true;
+                if (query.type() == A || query.type() == AAAA) {
                     if (auto record = generateRecord(message.address(), query.type()); record)
                         reply.addRecord(*record);
+                    else
+                        negative = true;
+                } else if (query.type() == ANY) {
+                    const auto records = addressRecords(message.address());
+                    for (Record const& record : records)
+                        reply.addRecord(record);
+                } else {
+                    negative = true;
                 }
             }
 
+            // The address of the other family, or its absence, saves peers
+            // another query (RFC 6762 §6.2)
+            if (queried)
+                addAdditionalRecords(reply, message.address(), negative);
+
             if (reply.records().count())
                 server->sendMessage(reply);
         }
@@ -151,6 +270,9 @@ public:
         if (hostname != hostnamePrev)
             emit q_ptr->hostnameChanged(hostname);
 
+        // Announce the addresses, so peers do not have to query them
+        Announcer::instance(server)->announce(q_ptr, generateAllRecords());
+
         // Re-assert the hostname in half an hour
         rebroadcastTimer.start();
     }
@@ -170,11 +292,12 @@ private:
     QByteArray wantedHostname;
     QByteArray hostnamePrev;
     QByteArray hostname;
+    DomainName hostnameName;
     bool hostnameRegistered {false};
     int hostnameSuffix {0};
 
-    QTimer registrationTimer;
-    QTimer rebroadcastTimer;
+    QueuedTimer registrationTimer;
+    QueuedTimer rebroadcastTimer;
 };
 
 
@@ -204,4 +327,10 @@ QByteArray Hostname::hostname() const
     return d->hostname;
 }
 
+QList<Record> Hostname::addressRecords(const QHostAddress &peer) const
+{
+    Q_D(const Hostname);
+    return d->addressRecords(peer);
+}
+
 } // namespace QtMdns
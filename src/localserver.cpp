@@ -0,0 +1,198 @@
+#include <qtmdns/dns.hpp>
+#include <qtmdns/localserver.hpp>
+#include <qtmdns/mdns.hpp>
+#include <qtmdns/message.hpp>
+
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+
+namespace QtMdns {
+
+class LocalNetworkPrivate
+{
+public:
+    void transmit(LocalNetwork* q, LocalServer* sender, QByteArray const& packet, QHostAddress const& destination)
+    {
+        bool const multicast = destination.isNull()
+                               || destination == mdnsDefaults().MdnsIpv4Address
+                               || destination == mdnsDefaults().MdnsIpv6Address;
+
+        ++packetsSent;
+        bytesSent += packet.size();
+
+        QHostAddress const source = sender->address();
+        for (QPointer<LocalServer> const& server : qAsConst(servers)) {
+            if ( ! server)
+                continue;
+            if ( ! multicast && server->address() != destination)
+                continue;
+
+            // The receiver is used as context so that packets in flight to a
+            // destroyed server are silently dropped
+            LocalServer* const receiver = server;
+            QTimer::singleShot(latency, receiver, [network=QPointer<LocalNetwork>(q), receiver, packet, source]() {
+                if (receiver->receivePacket(packet, source, mdnsDefaults().MdnsPort) && network)
+                    ++network->dd_ptr->packetsDelivered;
+            });
+        }
+    }
+
+    QList<QPointer<LocalServer>> servers;
+    int latency {0};
+    quint64 packetsSent {0};
+    quint64 bytesSent {0};
+    quint64 packetsDelivered {0};
+};
+
+
+LocalNetwork::LocalNetwork(QObject* parent) :
+    QObject(parent),
+    dd_ptr(new LocalNetworkPrivate)
+{}
+
+LocalNetwork::~LocalNetwork()
+{}
+
+
+int LocalNetwork::latency() const
+{
+    Q_D(const LocalNetwork);
+    return d->latency;
+}
+
+void LocalNetwork::setLatency(int msecs)
+{
+    Q_D(LocalNetwork);
+    d->latency = qMax(0, msecs);
+}
+
+quint64 LocalNetwork::packetsSent() const
+{
+    Q_D(const LocalNetwork);
+    return d->packetsSent;
+}
+
+quint64 LocalNetwork::bytesSent() const
+{
+    Q_D(const LocalNetwork);
+    return d->bytesSent;
+}
+
+quint64 LocalNetwork::packetsDelivered() const
+{
+    Q_D(const LocalNetwork);
+    return d->packetsDelivered;
+}
+
+void LocalNetwork::resetCounters()
+{
+    Q_D(LocalNetwork);
+    d->packetsSent = 0;
+    d->bytesSent = 0;
+    d->packetsDelivered = 0;
+}
+
+
+
+class LocalServerPrivate
+{
+public:
+    LocalServerPrivate(LocalNetwork* network, QHostAddress address) :
+        network(network),
+        address(std::move(address))
+    {}
+
+    QPointer<LocalNetwork> network;
+    QHostAddress address;
+    quint64 packetsSent {0};
+    quint64 packetsReceived {0};
+};
+
+
+LocalServer::LocalServer(LocalNetwork* network, QHostAddress address, QObject* parent) :
+    AbstractServer(parent),
+    dd_ptr(new LocalServerPrivate(network, std::move(address)))
+{
+    if (network)
+        network->dd_ptr->servers.append(this);
+}
+
+LocalServer::~LocalServer()
+{
+    sendGoodbyes();
+
+    Q_D(LocalServer);
+    if (d->network)
+        d->network->dd_ptr->servers.removeAll(this);
+}
+
+
+QHostAddress LocalServer::address() const
+{
+    Q_D(const LocalServer);
+    return d->address;
+}
+
+quint64 LocalServer::packetsSent() const
+{
+    Q_D(const LocalServer);
+    return d->packetsSent;
+}
+
+quint64 LocalServer::packetsReceived() const
+{
+    Q_D(const LocalServer);
+    return d->packetsReceived;
+}
+
+void LocalServer::sendMessage(Message const& message)
+{
+    send(message, message.address());
+}
+
+void LocalServer::sendMessageToAll(Message const& message)
+{
+    send(message, QHostAddress());
+}
+
+void LocalServer::send(Message const& message, QHostAddress const& destination)
+{
+    Q_D(LocalServer);
+    if ( ! d->network)
+        return;
+
+    QByteArray const packet = toPacket(message);
+    ++d->packetsSent;
+    countMessage(message, true);
+    countPacketSent(packet.size());
+    tracePacket(TracedPacket::Sent, packet, destination.isNull() ? mdnsDefaults().MdnsIpv4Address : destination,
+                mdnsDefaults().MdnsPort);
+
+    emit d->network->packetSent(this, packet);
+    d->network->dd_ptr->transmit(d->network, this, packet, destination);
+}
+
+bool LocalServer::receivePacket(QByteArray const& packet, QHostAddress const& address, quint16 port)
+{
+    Q_D(LocalServer);
+    ++d->packetsReceived;
+    countPacketReceived(packet.size());
+    tracePacket(TracedPacket::Received, packet, address, port);
+
+    Message message;
+    ParseError error;
+    if ( ! fromPacket(packet, message, error)) {
+        countParseFailure(error);
+        return false;
+    }
+
+    message.setAddress(address);
+    message.setPort(port);
+
+    countMessage(message, false);
+    emit messageReceived(message);
+    return true;
+}
+
+} // namespace QtMdns
@@ -8,7 +8,8 @@ Defaults const& mdnsDefaults()
         .MdnsPort = 5353,
         .MdnsIpv4Address = QHostAddress{"224.0.0.251"},
         .MdnsIpv6Address = QHostAddress{"ff02::fb"},
-        .MdnsBrowseType = QByteArray{"_services._dns-sd._udp.local."}
+        .MdnsBrowseType = QByteArray{"_services._dns-sd._udp.local."},
+        .MdnsMaxPacketSize = 1500 - 40 - 8
     };
     return def;
 }
@@ -3,19 +3,48 @@
 #include <qtmdns/query.hpp>
 #include <qtmdns/record.hpp>
 
+#include "objectpool.hpp"
+
 
 namespace QtMdns {
 
 class MessagePrivate
 {
 public:
+    QTMDNS_POOLED_ALLOCATION(MessagePrivate)
+
     QHostAddress address;
     quint16 port {0};
     quint16 transactionId {0};
     bool isResponse {false};
     bool isTruncated {false};
+
+    // Index in records of the first record of a section
+    qsizetype sectionStart(Message::Section section) const
+    {
+        switch (section) {
+        case Message::Answer:     return 0;
+        case Message::Authority:  return answerCount;
+        case Message::Additional: return answerCount + authorityCount;
+        }
+        return records.size();
+    }
+
+    // Index at which to insert a record of the section; records are mostly
+    // added section by section, in which case this is the end of the list
+    qsizetype insertionIndex(Message::Section section)
+    {
+        switch (section) {
+        case Message::Answer:    return answerCount++;
+        case Message::Authority: return answerCount + authorityCount++;
+        default:                 return records.size();
+        }
+    }
+
     QList<Query> queries;
-    QList<Record> records;
+    QList<Record> records;  // Sorted by section
+    qsizetype answerCount {0};
+    qsizetype authorityCount {0};
 };
 
 
@@ -30,12 +59,24 @@ Message::Message(const Message &other) :
     *this = other;
 }
 
+Message::Message(Message &&other) :
+    dd_ptr(new MessagePrivate)
+{
+    dd_ptr.swap(other.dd_ptr);
+}
+
 Message& Message::operator=(const Message &other)
 {
     *dd_ptr = *other.dd_ptr;
     return *this;
 }
 
+Message& Message::operator=(Message &&other) noexcept
+{
+    dd_ptr.swap(other.dd_ptr);
+    return *this;
+}
+
 Message::~Message()
 {
 }
@@ -113,6 +154,12 @@ void Message::addQuery(Query const& query)
     d->queries.append(query);
 }
 
+void Message::addQuery(Query&& query)
+{
+    Q_D(Message);
+    d->queries.append(std::move(query));
+}
+
 void Message::addQueries(QList<Query> const& queries)
 {
     Q_D(Message);
@@ -125,10 +172,31 @@ QList<Record> Message::records() const
     return d->records;
 }
 
-void Message::addRecord(const Record &record)
+QList<Record> Message::records(Section section) const
+{
+    Q_D(const Message);
+    qsizetype const start = d->sectionStart(section);
+    qsizetype const end = section == Additional ? d->records.size() : d->sectionStart(Section(section + 1));
+    return d->records.mid(start, end - start);
+}
+
+void Message::addRecord(const Record &record, Section section)
+{
+    Q_D(Message);
+    d->records.insert(d->insertionIndex(section), record);
+}
+
+void Message::addRecord(Record &&record, Section section)
+{
+    Q_D(Message);
+    d->records.insert(d->insertionIndex(section), std::move(record));
+}
+
+void Message::reserve(qsizetype queries, qsizetype records)
 {
     Q_D(Message);
-    d->records.append(record);
+    d->queries.reserve(d->queries.size() + queries);
+    d->records.reserve(d->records.size() + records);
 }
 
 void Message::reply(const Message &other)
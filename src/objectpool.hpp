@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <cstddef>
+#include <new>
+
+namespace QtMdns {
+
+/**
+ * @brief Per-thread free list of fixed-size blocks
+ *
+ * Decoding a packet creates a private object for the message and for each of
+ * its queries and records, and they are all destroyed once the message has
+ * been dispatched. Pooled classes return their blocks to a free list instead
+ * of the heap, so decoding the next packet reuses them without allocating.
+ *
+ * Blocks freed on another thread join the free list of that thread. Each list
+ * is capped, extra blocks go back to the heap.
+ */
+template<std::size_t Size>
+class ObjectPool
+{
+public:
+    static void* allocate()
+    {
+        FreeList& list = freeList();
+        if (list.head) {
+            Block* const block = list.head;
+            list.head = block->next;
+            --list.count;
+            return block;
+        }
+        return ::operator new(BlockSize);
+    }
+
+    static void release(void* pointer) noexcept
+    {
+        FreeList& list = freeList();
+        if (list.destroyed || list.count >= MaxFreeBlocks) {
+            ::operator delete(pointer);
+            return;
+        }
+
+        Block* const block = static_cast<Block*>(pointer);
+        block->next = list.head;
+        list.head = block;
+        ++list.count;
+    }
+
+private:
+    struct Block
+    {
+        Block* next;
+    };
+
+    static constexpr std::size_t BlockSize = Size < sizeof(Block) ? sizeof(Block) : Size;
+    static constexpr int MaxFreeBlocks = 1024;
+
+    struct FreeList
+    {
+        ~FreeList()
+        {
+            // Objects destroyed later on this thread go straight to the heap
+            destroyed = true;
+            while (head) {
+                Block* const next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+            count = 0;
+        }
+
+        Block* head {nullptr};
+        int count {0};
+        bool destroyed {false};
+    };
+
+    static FreeList& freeList()
+    {
+        thread_local FreeList list;
+        return list;
+    }
+};
+
+} // namespace QtMdns
+
+/**
+ * Allocate instances of Class from an ObjectPool. Class must not be derived
+ * from, as blocks are sized for Class exactly.
+ */
+#define QTMDNS_POOLED_ALLOCATION(Class) \
+    static void* operator new(std::size_t size) \
+    { \
+        Q_ASSERT(size == sizeof(Class)); \
+        Q_UNUSED(size) \
+        return QtMdns::ObjectPool<sizeof(Class)>::allocate(); \
+    } \
+    static void operator delete(void* pointer) noexcept \
+    { \
+        QtMdns::ObjectPool<sizeof(Class)>::release(pointer); \
+    }
@@ -0,0 +1,692 @@
+#include <qtmdns/localserver.hpp>
+#include <qtmdns/mdns.hpp>
+#include <qtmdns/packettrace.hpp>
+
+#include <QIODevice>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QNetworkInterface>
+#include <QtEndian>
+
+namespace QtMdns {
+
+namespace {
+
+// pcapng block types and link types, see
+// https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng-02.html
+constexpr quint32 SectionHeaderBlock = 0x0A0D0D0A;
+constexpr quint32 InterfaceDescriptionBlock = 1;
+constexpr quint32 SimplePacketBlock = 3;
+constexpr quint32 EnhancedPacketBlock = 6;
+constexpr quint32 ByteOrderMagic = 0x1A2B3C4D;
+
+constexpr quint32 PcapMagicMicroseconds = 0xA1B2C3D4;
+constexpr quint32 PcapMagicNanoseconds = 0xA1B23C4D;
+
+constexpr quint16 OptionEnd = 0;
+constexpr quint16 OptionIfName = 2;
+constexpr quint16 OptionIfTsresol = 9;
+constexpr quint16 OptionEpbFlags = 2;
+
+constexpr quint16 LinkTypeNull = 0;
+constexpr quint16 LinkTypeEthernet = 1;
+constexpr quint16 LinkTypeRaw = 101;
+constexpr quint16 LinkTypeLinuxSll = 113;
+constexpr quint16 LinkTypeIpv4 = 228;
+constexpr quint16 LinkTypeIpv6 = 229;
+constexpr quint16 LinkTypeLinuxSll2 = 276;
+
+constexpr char LogMagic[8] = {'Q', 'M', 'D', 'N', 'S', 'L', 'O', 'G'};
+constexpr quint16 LogVersion = 1;
+
+
+// Little-endian block writer; pcapng readers accept either byte order
+struct BlockWriter
+{
+    template<class T>
+    void write(T value)
+    {
+        value = qToLittleEndian<T>(value);
+        data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writePadded(QByteArray const& bytes)
+    {
+        data.append(bytes);
+        data.append((4 - bytes.size() % 4) % 4, '\0');
+    }
+
+    void writeOption(quint16 code, QByteArray const& value)
+    {
+        write<quint16>(code);
+        write<quint16>(static_cast<quint16>(value.size()));
+        writePadded(value);
+    }
+
+    QByteArray block(quint32 type) const
+    {
+        // Type, total length, body, total length
+        quint32 const length = static_cast<quint32>(data.size()) + 12;
+        BlockWriter out;
+        out.write<quint32>(type);
+        out.write<quint32>(length);
+        out.data.append(data);
+        out.write<quint32>(length);
+        return out.data;
+    }
+
+    QByteArray data;
+};
+
+quint16 ipv4Checksum(QByteArray const& header)
+{
+    quint32 sum = 0;
+    for (int i = 0; i + 1 < header.size(); i += 2)
+        sum += qFromBigEndian<quint16>(header.constData() + i);
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return static_cast<quint16>(~sum);
+}
+
+// Wrap a DNS payload in synthesized IP and UDP headers
+QByteArray ipDatagram(TracedPacket const& packet)
+{
+    bool const received = packet.direction == TracedPacket::Received;
+    bool const ipv6 = packet.address.protocol() == QAbstractSocket::IPv6Protocol;
+
+    QHostAddress const group = ipv6 ? mdnsDefaults().MdnsIpv6Address : mdnsDefaults().MdnsIpv4Address;
+    QHostAddress const local = ipv6 ? QHostAddress(QHostAddress::AnyIPv6) : QHostAddress(QHostAddress::AnyIPv4);
+    QHostAddress const source = received ? packet.address : local;
+    QHostAddress const destination = received ? group : packet.address;
+    quint16 const sourcePort = received ? packet.port : mdnsDefaults().MdnsPort;
+    quint16 const destinationPort = received ? mdnsDefaults().MdnsPort : packet.port;
+
+    quint16 const udpLength = static_cast<quint16>(8 + packet.data.size());
+    QByteArray udp(8, '\0');
+    qToBigEndian<quint16>(sourcePort, udp.data());
+    qToBigEndian<quint16>(destinationPort, udp.data() + 2);
+    qToBigEndian<quint16>(udpLength, udp.data() + 4);
+    udp.append(packet.data);
+
+    QByteArray ip;
+    if (ipv6) {
+        ip = QByteArray(40, '\0');
+        ip[0] = 0x60;
+        qToBigEndian<quint16>(udpLength, ip.data() + 4);
+        ip[6] = 17;
+        ip[7] = static_cast<char>(255);
+        Q_IPV6ADDR const src = source.toIPv6Address();
+        Q_IPV6ADDR const dst = destination.toIPv6Address();
+        memcpy(ip.data() + 8, &src, 16);
+        memcpy(ip.data() + 24, &dst, 16);
+    } else {
+        ip = QByteArray(20, '\0');
+        ip[0] = 0x45;
+        qToBigEndian<quint16>(static_cast<quint16>(20 + udpLength), ip.data() + 2);
+        ip[8] = static_cast<char>(255);
+        ip[9] = 17;
+        qToBigEndian<quint32>(source.toIPv4Address(), ip.data() + 12);
+        qToBigEndian<quint32>(destination.toIPv4Address(), ip.data() + 16);
+        qToBigEndian<quint16>(ipv4Checksum(ip), ip.data() + 10);
+    }
+
+    return ip + udp;
+}
+
+// Extract the mDNS payload of an IP datagram; false if it is not one
+bool parseIpDatagram(const uchar* data, qsizetype length, TracedPacket& packet)
+{
+    if (length < 1)
+        return false;
+
+    QHostAddress source, destination;
+    qsizetype offset;
+    switch (data[0] >> 4) {
+    case 4:
+    {
+        qsizetype const headerLength = (data[0] & 0x0f) * 4;
+        if (length < 20 || headerLength < 20 || length < headerLength + 8 || data[9] != 17)
+            return false;
+        if (qFromBigEndian<quint16>(data + 6) & 0x3fff)
+            return false;  // fragment
+        source = QHostAddress(qFromBigEndian<quint32>(data + 12));
+        destination = QHostAddress(qFromBigEndian<quint32>(data + 16));
+        offset = headerLength;
+        break;
+    }
+    case 6:
+        if (length < 48 || data[6] != 17)
+            return false;  // extension headers are not supported
+        source = QHostAddress(data + 8);
+        destination = QHostAddress(data + 24);
+        offset = 40;
+        break;
+    default:
+        return false;
+    }
+
+    quint16 const sourcePort = qFromBigEndian<quint16>(data + offset);
+    quint16 const destinationPort = qFromBigEndian<quint16>(data + offset + 2);
+    quint16 const udpLength = qFromBigEndian<quint16>(data + offset + 4);
+    if (udpLength < 8 || offset + udpLength > length)
+        return false;
+    if (sourcePort != mdnsDefaults().MdnsPort && destinationPort != mdnsDefaults().MdnsPort)
+        return false;
+
+    if (packet.direction == TracedPacket::Sent) {
+        packet.address = destination;
+        packet.port = destinationPort;
+    } else {
+        packet.address = source;
+        packet.port = sourcePort;
+    }
+    packet.data = QByteArray(reinterpret_cast<const char*>(data + offset + 8), udpLength - 8);
+    return true;
+}
+
+// Strip the link-layer header, then parse the IP datagram
+bool parseFrame(quint16 linkType, const uchar* data, qsizetype length, TracedPacket& packet)
+{
+    qsizetype offset = 0;
+    switch (linkType) {
+    case LinkTypeRaw:
+    case LinkTypeIpv4:
+    case LinkTypeIpv6:
+        break;
+    case LinkTypeNull:
+        offset = 4;
+        break;
+    case LinkTypeEthernet:
+    {
+        offset = 14;
+        if (length < offset)
+            return false;
+        quint16 etherType = qFromBigEndian<quint16>(data + 12);
+        while (etherType == 0x8100 || etherType == 0x88a8) {  // VLAN tags
+            offset += 4;
+            if (length < offset)
+                return false;
+            etherType = qFromBigEndian<quint16>(data + offset - 2);
+        }
+        if (etherType != 0x0800 && etherType != 0x86dd)
+            return false;
+        break;
+    }
+    case LinkTypeLinuxSll:
+        offset = 16;
+        break;
+    case LinkTypeLinuxSll2:
+        offset = 20;
+        break;
+    default:
+        return false;
+    }
+
+    if (length < offset)
+        return false;
+    return parseIpDatagram(data + offset, length - offset, packet);
+}
+
+} // namespace
+
+
+class PacketTracePrivate
+{
+public:
+    explicit PacketTracePrivate(int capacity) :
+        capacity(qMax(1, capacity))
+    {}
+
+    QList<TracedPacket> ordered() const
+    {
+        // Caller holds mutex
+        QList<TracedPacket> packets;
+        packets.reserve(ring.size());
+        for (int i = 0; i < ring.size(); ++i)
+            packets.append(ring.at((head + i) % ring.size()));
+        return packets;
+    }
+
+    mutable QMutex mutex;
+    QList<TracedPacket> ring;
+    int head {0};  // index of the oldest packet once the ring is full
+    int capacity {1};
+    quint64 dropped {0};
+};
+
+
+PacketTrace::PacketTrace(int capacity) :
+    dd_ptr(new PacketTracePrivate(capacity))
+{}
+
+PacketTrace::~PacketTrace()
+{}
+
+
+int PacketTrace::capacity() const
+{
+    Q_D(const PacketTrace);
+    QMutexLocker locker(&d->mutex);
+    return d->capacity;
+}
+
+void PacketTrace::setCapacity(int capacity)
+{
+    Q_D(PacketTrace);
+    QMutexLocker locker(&d->mutex);
+
+    QList<TracedPacket> packets = d->ordered();
+    d->capacity = qMax(1, capacity);
+    if (packets.size() > d->capacity) {
+        d->dropped += packets.size() - d->capacity;
+        packets.erase(packets.begin(), packets.begin() + (packets.size() - d->capacity));
+    }
+
+    d->ring = packets;
+    d->head = 0;
+}
+
+int PacketTrace::count() const
+{
+    Q_D(const PacketTrace);
+    QMutexLocker locker(&d->mutex);
+    return d->ring.size();
+}
+
+quint64 PacketTrace::dropped() const
+{
+    Q_D(const PacketTrace);
+    QMutexLocker locker(&d->mutex);
+    return d->dropped;
+}
+
+void PacketTrace::add(TracedPacket packet)
+{
+    Q_D(PacketTrace);
+    QMutexLocker locker(&d->mutex);
+
+    if (d->ring.size() < d->capacity) {
+        d->ring.append(std::move(packet));
+    } else {
+        d->ring[d->head] = std::move(packet);
+        d->head = (d->head + 1) % d->ring.size();
+        ++d->dropped;
+    }
+}
+
+QList<TracedPacket> PacketTrace::packets() const
+{
+    Q_D(const PacketTrace);
+    QMutexLocker locker(&d->mutex);
+    return d->ordered();
+}
+
+void PacketTrace::clear()
+{
+    Q_D(PacketTrace);
+    QMutexLocker locker(&d->mutex);
+    d->ring.clear();
+    d->head = 0;
+    d->dropped = 0;
+}
+
+
+bool PacketTrace::writePcapng(QIODevice* device) const
+{
+    QList<TracedPacket> const packets = this->packets();
+
+    // A short write leaves a truncated block, which makes the file unreadable
+    auto const writeBlock = [device](QByteArray const& block) {
+        return device->write(block) == block.size();
+    };
+
+    BlockWriter shb;
+    shb.write<quint32>(ByteOrderMagic);
+    shb.write<quint16>(1);  // major version
+    shb.write<quint16>(0);  // minor version
+    shb.write<qint64>(-1);  // unknown section length
+    if ( ! writeBlock(shb.block(SectionHeaderBlock)))
+        return false;
+
+    // One interface description per interface index, in order of appearance
+    QMap<int, quint32> interfaceIds;
+    for (TracedPacket const& packet : packets) {
+        if (interfaceIds.contains(packet.interfaceIndex))
+            continue;
+
+        BlockWriter idb;
+        idb.write<quint16>(LinkTypeRaw);
+        idb.write<quint16>(0);  // reserved
+        idb.write<quint32>(0);  // no snap length
+        if (packet.interfaceIndex > 0) {
+            QByteArray const name = QNetworkInterface::interfaceNameFromIndex(packet.interfaceIndex).toUtf8();
+            if ( ! name.isEmpty())
+                idb.writeOption(OptionIfName, name);
+        }
+        idb.writeOption(OptionIfTsresol, QByteArray(1, 6));  // microseconds
+        idb.writeOption(OptionEnd, QByteArray());
+        if ( ! writeBlock(idb.block(InterfaceDescriptionBlock)))
+            return false;
+
+        interfaceIds.insert(packet.interfaceIndex, static_cast<quint32>(interfaceIds.size()));
+    }
+
+    for (TracedPacket const& packet : packets) {
+        QByteArray const datagram = ipDatagram(packet);
+        quint64 const timestamp = static_cast<quint64>(packet.timestamp);
+
+        BlockWriter epb;
+        epb.write<quint32>(interfaceIds.value(packet.interfaceIndex));
+        epb.write<quint32>(static_cast<quint32>(timestamp >> 32));
+        epb.write<quint32>(static_cast<quint32>(timestamp));
+        epb.write<quint32>(static_cast<quint32>(datagram.size()));
+        epb.write<quint32>(static_cast<quint32>(datagram.size()));
+        epb.writePadded(datagram);
+
+        BlockWriter flags;
+        flags.write<quint32>(packet.direction == TracedPacket::Received ? 1 : 2);
+        epb.writeOption(OptionEpbFlags, flags.data);
+        epb.writeOption(OptionEnd, QByteArray());
+
+        if ( ! writeBlock(epb.block(EnhancedPacketBlock)))
+            return false;
+    }
+
+    return true;
+}
+
+bool PacketTrace::writeLog(QIODevice* device) const
+{
+    QList<TracedPacket> const packets = this->packets();
+
+    BlockWriter log;
+    log.data.append(LogMagic, sizeof(LogMagic));
+    log.write<quint16>(LogVersion);
+
+    for (TracedPacket const& packet : packets) {
+        bool const ipv6 = packet.address.protocol() == QAbstractSocket::IPv6Protocol;
+        bool const ipv4 = packet.address.protocol() == QAbstractSocket::IPv4Protocol;
+
+        log.write<qint64>(packet.timestamp);
+        log.write<quint8>(packet.direction);
+        log.write<qint32>(packet.interfaceIndex);
+        log.write<quint8>(ipv6 ? 6 : ipv4 ? 4 : 0);
+        if (ipv6) {
+            Q_IPV6ADDR const address = packet.address.toIPv6Address();
+            log.data.append(reinterpret_cast<const char*>(&address), 16);
+        } else if (ipv4) {
+            log.write<quint32>(packet.address.toIPv4Address());
+        }
+        log.write<quint16>(packet.port);
+        log.write<quint32>(static_cast<quint32>(packet.data.size()));
+        log.data.append(packet.data);
+    }
+
+    return device->write(log.data) == log.data.size();
+}
+
+
+bool PacketTrace::readPcapng(QIODevice* device, QList<TracedPacket>& packets)
+{
+    struct Interface
+    {
+        quint16 linkType;
+        int index;
+        quint64 unitsPerSecond;
+    };
+
+    QByteArray const capture = device->readAll();
+    const uchar* const data = reinterpret_cast<const uchar*>(capture.constData());
+    qsizetype const size = capture.size();
+
+    bool bigEndian = false;
+    auto read16 = [&](qsizetype offset) {
+        return bigEndian ? qFromBigEndian<quint16>(data + offset) : qFromLittleEndian<quint16>(data + offset);
+    };
+    auto read32 = [&](qsizetype offset) {
+        return bigEndian ? qFromBigEndian<quint32>(data + offset) : qFromLittleEndian<quint32>(data + offset);
+    };
+
+    QList<Interface> interfaces;
+    qsizetype offset = 0;
+    bool sectionFound = false;
+    while (offset + 12 <= size) {
+        quint32 const type = qFromLittleEndian<quint32>(data + offset);
+
+        if (type == SectionHeaderBlock) {
+            // The byte order magic decides how the rest of the section is read
+            quint32 const magic = qFromLittleEndian<quint32>(data + offset + 8);
+            if (magic == ByteOrderMagic)
+                bigEndian = false;
+            else if (qFromBigEndian<quint32>(data + offset + 8) == ByteOrderMagic)
+                bigEndian = true;
+            else
+                return false;
+
+            interfaces.clear();
+            sectionFound = true;
+        } else if ( ! sectionFound) {
+            return false;
+        }
+
+        quint32 const length = read32(offset + 4);
+        if (length < 12 || length % 4 || offset + length > size)
+            return false;
+
+        qsizetype const body = offset + 8;
+        qsizetype const bodyEnd = offset + length - 4;
+
+        switch (bigEndian ? qFromBigEndian<quint32>(data + offset) : type) {
+        case InterfaceDescriptionBlock:
+        {
+            if (body + 8 > bodyEnd)
+                return false;
+
+            Interface interface {read16(body), 0, 1000000};
+            for (qsizetype option = body + 8; option + 4 <= bodyEnd;) {
+                quint16 const code = read16(option);
+                quint16 const optionLength = read16(option + 2);
+                if (code == OptionEnd || option + 4 + optionLength > bodyEnd)
+                    break;
+
+                if (code == OptionIfName) {
+                    QString const name = QString::fromUtf8(QByteArray(reinterpret_cast<const char*>(data + option + 4), optionLength));
+                    interface.index = QNetworkInterface::interfaceIndexFromName(name);
+                } else if (code == OptionIfTsresol && optionLength == 1) {
+                    // A resolution of 2^-64 or 10^-20 seconds and finer does
+                    // not fit in 64 bits
+                    quint8 const resolution = data[option + 4];
+                    bool const binary = resolution & 0x80;
+                    int const exponent = resolution & 0x7f;
+                    if (exponent > (binary ? 63 : 19))
+                        return false;
+
+                    interface.unitsPerSecond = 1;
+                    for (int i = 0; i < exponent; ++i)
+                        interface.unitsPerSecond *= binary ? 2 : 10;
+                }
+                option += 4 + ((optionLength + 3) & ~3);
+            }
+            interfaces.append(interface);
+            break;
+        }
+        case EnhancedPacketBlock:
+        {
+            if (body + 20 > bodyEnd)
+                return false;
+
+            quint32 const interfaceId = read32(body);
+            quint32 const capturedLength = read32(body + 12);
+            if (interfaceId >= static_cast<quint32>(interfaces.size()) || body + 20 + capturedLength > bodyEnd)
+                return false;
+
+            Interface const& interface = interfaces.at(interfaceId);
+            TracedPacket packet;
+            packet.interfaceIndex = interface.index;
+
+            // Look for the direction in the epb_flags option
+            for (qsizetype option = body + 20 + ((capturedLength + 3) & ~3); option + 4 <= bodyEnd;) {
+                quint16 const code = read16(option);
+                quint16 const optionLength = read16(option + 2);
+                if (code == OptionEnd || option + 4 + optionLength > bodyEnd)
+                    break;
+                if (code == OptionEpbFlags && optionLength == 4 && (read32(option + 4) & 0x3) == 2)
+                    packet.direction = TracedPacket::Sent;
+                option += 4 + ((optionLength + 3) & ~3);
+            }
+
+            // The remainder times 10^6 would overflow for resolutions finer
+            // than about 2^-44 seconds, its share is computed in floating point
+            quint64 const units = (static_cast<quint64>(read32(body + 4)) << 32) | read32(body + 8);
+            quint64 const unitsPerSecond = interface.unitsPerSecond;
+            packet.timestamp = static_cast<qint64>(units / unitsPerSecond * 1000000
+                                                   + static_cast<quint64>(static_cast<double>(units % unitsPerSecond)
+                                                                          * 1000000 / static_cast<double>(unitsPerSecond)));
+
+            if (parseFrame(interface.linkType, data + body + 20, capturedLength, packet))
+                packets.append(packet);
+            break;
+        }
+        case SimplePacketBlock:
+        {
+            if (interfaces.isEmpty() || body + 4 > bodyEnd)
+                return false;
+
+            TracedPacket packet;
+            packet.interfaceIndex = interfaces.at(0).index;
+            if (parseFrame(interfaces.at(0).linkType, data + body + 4, bodyEnd - body - 4, packet))
+                packets.append(packet);
+            break;
+        }
+        default:
+            break;
+        }
+
+        offset += length;
+    }
+
+    return sectionFound && offset == size;
+}
+
+bool PacketTrace::readPcap(QIODevice* device, QList<TracedPacket>& packets)
+{
+    QByteArray const capture = device->readAll();
+    const uchar* const data = reinterpret_cast<const uchar*>(capture.constData());
+    qsizetype const size = capture.size();
+
+    if (size < 24)
+        return false;
+
+    bool bigEndian;
+    quint32 const magic = qFromLittleEndian<quint32>(data);
+    quint32 const magicBigEndian = qFromBigEndian<quint32>(data);
+    if (magic == PcapMagicMicroseconds || magic == PcapMagicNanoseconds)
+        bigEndian = false;
+    else if (magicBigEndian == PcapMagicMicroseconds || magicBigEndian == PcapMagicNanoseconds)
+        bigEndian = true;
+    else
+        return false;
+
+    auto read32 = [&](qsizetype offset) {
+        return bigEndian ? qFromBigEndian<quint32>(data + offset) : qFromLittleEndian<quint32>(data + offset);
+    };
+
+    bool const nanoseconds = (bigEndian ? magicBigEndian : magic) == PcapMagicNanoseconds;
+    quint16 const linkType = static_cast<quint16>(read32(20) & 0xffff);
+
+    qsizetype offset = 24;
+    while (offset + 16 <= size) {
+        quint32 const seconds = read32(offset);
+        quint32 const fraction = read32(offset + 4);
+        quint32 const capturedLength = read32(offset + 8);
+        offset += 16;
+        if (offset + capturedLength > size)
+            return false;
+
+        TracedPacket packet;
+        packet.timestamp = static_cast<qint64>(seconds) * 1000000 + (nanoseconds ? fraction / 1000 : fraction);
+        if (parseFrame(linkType, data + offset, capturedLength, packet))
+            packets.append(packet);
+
+        offset += capturedLength;
+    }
+
+    return offset == size;
+}
+
+bool PacketTrace::readCapture(QIODevice* device, QList<TracedPacket>& packets)
+{
+    QByteArray const header = device->peek(8);
+    if (header.size() < 4)
+        return false;
+
+    const uchar* const data = reinterpret_cast<const uchar*>(header.constData());
+    if (qFromLittleEndian<quint32>(data) == SectionHeaderBlock)
+        return readPcapng(device, packets);
+    if (header.size() == 8 && memcmp(data, LogMagic, sizeof(LogMagic)) == 0)
+        return readLog(device, packets);
+    return readPcap(device, packets);
+}
+
+bool PacketTrace::readLog(QIODevice* device, QList<TracedPacket>& packets)
+{
+    QByteArray const log = device->readAll();
+    const uchar* const data = reinterpret_cast<const uchar*>(log.constData());
+    qsizetype const size = log.size();
+
+    if (size < 10 || memcmp(data, LogMagic, sizeof(LogMagic)) != 0
+        || qFromLittleEndian<quint16>(data + 8) != LogVersion)
+    {
+        return false;
+    }
+
+    qsizetype offset = 10;
+    while (offset < size) {
+        // Fixed part: timestamp, direction, interface and address family
+        if (offset + 14 > size)
+            return false;
+
+        TracedPacket packet;
+        packet.timestamp = qFromLittleEndian<qint64>(data + offset);
+        packet.direction = data[offset + 8] == TracedPacket::Sent ? TracedPacket::Sent : TracedPacket::Received;
+        packet.interfaceIndex = qFromLittleEndian<qint32>(data + offset + 9);
+        quint8 const family = data[offset + 13];
+        offset += 14;
+
+        qsizetype const addressLength = family == 6 ? 16 : family == 4 ? 4 : 0;
+        if (offset + addressLength + 6 > size)
+            return false;
+        if (family == 6)
+            packet.address = QHostAddress(data + offset);
+        else if (family == 4)
+            packet.address = QHostAddress(qFromLittleEndian<quint32>(data + offset));
+        offset += addressLength;
+
+        packet.port = qFromLittleEndian<quint16>(data + offset);
+        quint32 const length = qFromLittleEndian<quint32>(data + offset + 2);
+        offset += 6;
+        if (offset + length > size)
+            return false;
+
+        packet.data = QByteArray(reinterpret_cast<const char*>(data + offset), length);
+        offset += length;
+        packets.append(packet);
+    }
+
+    return true;
+}
+
+int PacketTrace::replay(QList<TracedPacket> const& packets, LocalServer& server)
+{
+    int decoded = 0;
+    for (TracedPacket const& packet : packets) {
+        if (packet.direction != TracedPacket::Received)
+            continue;
+        if (server.receivePacket(packet.data, packet.address, packet.port))
+            ++decoded;
+    }
+    return decoded;
+}
+
+} // namespace QtMdns
@@ -1,15 +1,102 @@
 #include <qtmdns/abstractserver.hpp>
 #include <qtmdns/dns.hpp>
+#include <qtmdns/domainname.hpp>
+#include <qtmdns/mdns.hpp>
 #include <qtmdns/message.hpp>
 #include <qtmdns/prober.hpp>
 #include <qtmdns/query.hpp>
 #include <qtmdns/record.hpp>
 
+#include <QHash>
 #include <QPointer>
-#include <QTimer>
+
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+#include <QRandomGenerator>
+#define USE_QRANDOMGENERATOR
+#endif
+
+#include <algorithm>
+
+#include "timerqueue.hpp"
 
 namespace QtMdns {
 
+class ProberPrivate;
+
+namespace {
+
+// RFC 6762 §8.1: three probes, 250 ms apart, the first one after a random
+// delay of up to 250 ms; §8.2: a host losing a tiebreak waits one second
+// before probing again
+constexpr int ProbeCount = 3;
+constexpr int ProbeInterval = 250;
+constexpr int TiebreakDeferTicks = 1000 / ProbeInterval;
+
+// Order records as RFC 6762 §8.2.1 does: by class without the cache-flush
+// bit, which is always IN here, then by type, then by uncompressed rdata
+int compareRecords(Record const& a, Record const& b)
+{
+    if (a.type() != b.type())
+        return a.type() < b.type() ? -1 : 1;
+
+    QByteArray const dataA = rdataToWireFormat(a);
+    QByteArray const dataB = rdataToWireFormat(b);
+    return std::lexicographical_compare(dataA.cbegin(), dataA.cend(), dataB.cbegin(), dataB.cend(),
+                                        [](char x, char y) { return quint8(x) < quint8(y); })
+        ? -1 : (dataA == dataB ? 0 : 1);
+}
+
+// Compare sorted sets of records, a set with records left over wins
+int compareRecordSets(QList<Record> a, QList<Record> b)
+{
+    auto const less = [](Record const& x, Record const& y) { return compareRecords(x, y) < 0; };
+    std::sort(a.begin(), a.end(), less);
+    std::sort(b.begin(), b.end(), less);
+
+    for (qsizetype i = 0; i < a.size() && i < b.size(); ++i) {
+        if (int const result = compareRecords(a.at(i), b.at(i)))
+            return result;
+    }
+    return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
+
+} // namespace
+
+/**
+ * @brief Probes of all the probers of a server
+ *
+ * Every pending name is probed in the same message, on a single 250 ms
+ * timer, and received messages are matched once against all of them.
+ */
+class ProbeScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static ProbeScheduler* instance(AbstractServer* server)
+    {
+        ProbeScheduler* scheduler = server->findChild<ProbeScheduler*>(QString(), Qt::FindDirectChildrenOnly);
+        if ( ! scheduler)
+            scheduler = new ProbeScheduler(server);
+        return scheduler;
+    }
+
+    void add(ProberPrivate* prober);
+    void remove(ProberPrivate* prober);
+    void rename(ProberPrivate* prober, DomainName const& oldName);
+
+private:
+    explicit ProbeScheduler(AbstractServer* server);
+
+    void onTimeout();
+    void onMessageReceived(Message const& message);
+
+    AbstractServer* const server;
+    QueuedTimer timer;
+    QList<ProberPrivate*> probers;
+    QHash<DomainName, ProberPrivate*> probersByName;
+};
+
+
 class ProberPrivate : public QObject
 {
     Q_DISABLE_COPY_MOVE(ProberPrivate)
@@ -20,86 +107,199 @@ public:
     ProberPrivate(Prober* prober, AbstractServer* server, Record record) :
         QObject(prober),
         q_ptr(prober),
-        server(server),
-        confirmed(false),
-        proposedRecord(std::move(record)),
-        suffix(1)
+        scheduler(ProbeScheduler::instance(server)),
+        proposedRecord(std::move(record))
     {
-        // All records should contain at least one "."
-        qsizetype const index = record.name().indexOf('.');
-        name = record.name().left(index);
-        type = record.name().mid(index);
+        // The first label is the name to make unique, the rest is the type
+        name = proposedRecord.domainName().label(0);
+        type = proposedRecord.domainName().parent();
 
-        connect(server, &AbstractServer::messageReceived, this, &ProberPrivate::onMessageReceived);
-        connect(&timer, &QTimer::timeout, this, &ProberPrivate::onTimeout);
-
-        timer.setSingleShot(true);
-
-        assertRecord();
+        scheduler->add(this);
     }
 
-    void assertRecord()
+    ~ProberPrivate() override
     {
-        // Use the current suffix to set the name of the proposed record
-        QString const tmpName = suffix == 1
-                                ? QString("%1%2").arg(name, type.constData())
-                                : QString("%1-%2%3").arg(name.constData(), QByteArray::number(suffix), type);
-
-        proposedRecord.setName(tmpName.toUtf8());
-
-        // Broadcast a query for the proposed name (using an ANY query) and
-        // include the proposed record in the query
-        Query query;
-            query.setName(proposedRecord.name());
-            query.setType(ANY);
+        if (scheduler)
+            scheduler->remove(this);
+    }
 
-        Message message;
-            message.addQuery(query);
-            message.addRecord(proposedRecord);
+    // A response holds a record with the proposed name: pick the next name
+    // and start probing again
+    void onConflict()
+    {
+        DomainName const oldName = proposedRecord.domainName();
 
-        server->sendMessageToAll(message);
+        // Use the next suffix to set the name of the proposed record,
+        // shortening the name if the label would be too long
+        ++suffix;
+        QByteArray const suffixText = "-" + QByteArray::number(suffix);
+        proposedRecord.setName(type.child(name.left(63 - suffixText.size()) + suffixText));
 
-        // Wait two seconds to confirm it is unique
-        timer.stop();
-        timer.start(2 * 1000);
+        probesSent = 0;
+        deferTicks = 0;
+        scheduler->rename(this, oldName);
     }
 
-    void onMessageReceived(const Message &message)
+    // Another host probes the same name with records that win the tiebreak
+    void onTiebreakLost()
     {
-        // If the response matches the proposed record, increment the suffix and
-        // try with the new name
-
-        if (confirmed || ! message.isResponse())
-            return;
-
-        QList<Record> const& records = message.records();
-        for (const Record &record : records) {
-            if (record.name() == proposedRecord.name() && record.type() == proposedRecord.type()) {
-                ++suffix;
-                assertRecord();
-            }
-        }
+        probesSent = 0;
+        deferTicks = TiebreakDeferTicks;
     }
 
-    void onTimeout()
+    void confirm()
     {
         confirmed = true;
         emit q_ptr->nameConfirmed(proposedRecord.name());
     }
 
-private:
-    QPointer<AbstractServer> server;
-    QTimer timer;
+    QPointer<ProbeScheduler> scheduler;
 
     bool confirmed {false};
+    int probesSent {0};
+    int deferTicks {0};
 
     Record proposedRecord;
     QByteArray name;
-    QByteArray type;
-    int suffix {0};
+    DomainName type;
+    int suffix {1};
 };
 
 
+ProbeScheduler::ProbeScheduler(AbstractServer* server) :
+    QObject(server),
+    server(server),
+    timer([this]() { onTimeout(); })
+{
+    connect(server, &AbstractServer::messageReceived, this, &ProbeScheduler::onMessageReceived);
+
+    timer.setServer(server);
+}
+
+void ProbeScheduler::add(ProberPrivate* prober)
+{
+    probers.append(prober);
+    probersByName.insert(prober->proposedRecord.domainName(), prober);
+
+    // New probes join the next round; without one under way, the first probe
+    // waits a random delay so hosts starting together do not collide
+    if ( ! timer.isActive()) {
+#ifdef USE_QRANDOMGENERATOR
+        timer.start(QRandomGenerator::global()->bounded(ProbeInterval));
+#else
+        timer.start(qrand() % ProbeInterval);
+#endif
+    }
+}
+
+void ProbeScheduler::remove(ProberPrivate* prober)
+{
+    probers.removeOne(prober);
+    auto const it = probersByName.constFind(prober->proposedRecord.domainName());
+    if (it != probersByName.constEnd() && it.value() == prober)
+        probersByName.erase(it);
+
+    if (probers.isEmpty())
+        timer.stop();
+}
+
+void ProbeScheduler::rename(ProberPrivate* prober, DomainName const& oldName)
+{
+    auto const it = probersByName.constFind(oldName);
+    if (it != probersByName.constEnd() && it.value() == prober)
+        probersByName.erase(it);
+    probersByName.insert(prober->proposedRecord.domainName(), prober);
+}
+
+void ProbeScheduler::onTimeout()
+{
+    Message message;
+    QList<QPointer<ProberPrivate>> confirmed;
+
+    for (ProberPrivate* const prober : qAsConst(probers)) {
+        if (prober->deferTicks > 0) {
+            --prober->deferTicks;
+            continue;
+        }
+
+        // No conflict since the last probe was sent
+        if (prober->probesSent == ProbeCount) {
+            confirmed.append(prober);
+            continue;
+        }
+
+        // Query the proposed name (using an ANY query), asking for unicast
+        // responses in the first probe, and include the proposed record for
+        // tiebreaking
+        Query query;
+            query.setName(prober->proposedRecord.domainName());
+            query.setType(ANY);
+            query.setUnicastResponse(prober->probesSent == 0);
+
+        message.addQuery(std::move(query));
+        message.addRecord(prober->proposedRecord, Message::Authority);
+        ++prober->probesSent;
+    }
+
+    // With many names the probes span several packets, each question with
+    // its proposed record
+    const auto messages = splitMessage(message, mdnsDefaults().MdnsMaxPacketSize);
+    for (Message const& part : messages)
+        server->sendMessageToAll(part);
+
+    // Confirmed probers leave the schedule before their signal is emitted, as
+    // receivers may delete them
+    for (ProberPrivate* const prober : qAsConst(confirmed))
+        remove(prober);
+    for (QPointer<ProberPrivate> const& prober : qAsConst(confirmed)) {
+        if (prober)
+            prober->confirm();
+    }
+
+    if ( ! probers.isEmpty())
+        timer.start(ProbeInterval);
+}
+
+void ProbeScheduler::onMessageReceived(Message const& message)
+{
+    if (probersByName.isEmpty())
+        return;
+
+    if (message.isResponse()) {
+        QList<Record> const records = message.records();
+
+        // Any record with a proposed name, other than the proposed record
+        // itself, is a conflict (RFC 6762 §9)
+        QList<QPointer<ProberPrivate>> conflicts;
+        for (Record const& record : records) {
+            ProberPrivate* const prober = probersByName.value(record.domainName());
+            if (prober && record != prober->proposedRecord && ! conflicts.contains(prober))
+                conflicts.append(prober);
+        }
+        for (QPointer<ProberPrivate> const& prober : qAsConst(conflicts)) {
+            if (prober)
+                prober->onConflict();
+        }
+        return;
+    }
+
+    // Authority records of a query probing one of the proposed names are the
+    // other host's proposal: the lexicographically later set wins (RFC 6762
+    // §8.2)
+    QList<Record> const records = message.records(Message::Authority);
+    QHash<ProberPrivate*, QList<Record>> proposals;
+    for (Record const& record : records) {
+        if (ProberPrivate* const prober = probersByName.value(record.domainName()))
+            proposals[prober].append(record);
+    }
+    for (auto it = proposals.cbegin(); it != proposals.cend(); ++it) {
+        ProberPrivate* const prober = it.key();
+        if (prober->probesSent > 0 && compareRecordSets({prober->proposedRecord}, it.value()) < 0)
+            prober->onTiebreakLost();
+    }
+}
+
+
 Prober::Prober(AbstractServer* server, Record record, QObject* parent) :
     QObject(parent),
     dd_ptr(new ProberPrivate(this, server, std::move(record)))
@@ -111,3 +311,5 @@ Prober::~Prober()
 }
 
 } // namespace QtMdns
+
+#include "prober.moc"
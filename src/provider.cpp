@@ -1,5 +1,6 @@
 #include <qtmdns/abstractserver.hpp>
 #include <qtmdns/dns.hpp>
+#include <qtmdns/domainname.hpp>
 #include <qtmdns/hostname.hpp>
 #include <qtmdns/mdns.hpp>
 #include <qtmdns/message.hpp>
@@ -11,6 +12,8 @@
 
 #include <QPointer>
 
+#include "announcer.hpp"
+
 namespace QtMdns {
 
 class ProviderPrivate : public QObject
@@ -38,20 +41,19 @@ public:
 
     virtual ~ProviderPrivate()
     {
+        if ( ! server)
+            return;
+
         if (confirmed)
             farewell();
+        else
+            Announcer::instance(server)->cancel(this);
     }
 
     void announce()
     {
-        // Broadcast a message with each of the records
-        Message message;
-            message.setResponse(true);
-            message.addRecord(ptrRecord);
-            message.addRecord(srvRecord);
-            message.addRecord(txtRecord);
-
-        server->sendMessageToAll(message);
+        // Announce each of the records, along with the other local records
+        Announcer::instance(server)->announce(this, {ptrRecord, srvRecord, txtRecord});
     }
 
     void confirm()
@@ -83,13 +85,9 @@ public:
 
     void farewell()
     {
-        // Send a message indicating that the existing records are no longer valid
-        // by setting their TTL to 0
-        ptrRecord.setTtl(0);
-        srvRecord.setTtl(0);
-        txtRecord.setTtl(0);
-
-        announce();
+        // Indicate that the existing records are no longer valid, with the
+        // goodbyes of the other local records
+        Announcer::instance(server)->withdraw(this);
     }
 
     void publish()
@@ -113,55 +111,101 @@ public:
         bool sendPtr = false;
         bool sendSrv = false;
         bool sendTxt = false;
+        bool negative = false;
 
-        // Determine which records to send based on the queries
+        // Determine which records to send based on the queries; the service
+        // has no other record type than SRV and TXT, queries for those get a
+        // negative answer (RFC 6762 §6.1)
         const auto queries = message.queries();
         for (const Query &query : queries) {
-            if (query.type() == PTR && query.name() == mdnsDefaults().MdnsBrowseType) {
+            if (query.type() == PTR && query.domainName() == browsePtrProposed.domainName()) {
                 sendBrowsePtr = true;
-            } else if (query.type() == PTR && query.name() == ptrRecord.name()) {
+            } else if (query.type() == PTR && query.domainName() == ptrRecord.domainName()) {
                 sendPtr = true;
-            } else if (query.type() == SRV && query.name() == srvRecord.name()) {
+            } else if (query.type() == SRV && query.domainName() == srvRecord.domainName()) {
                 sendSrv = true;
-            } else if (query.type() == TXT && query.name() == txtRecord.name()) {
+            } else if (query.type() == TXT && query.domainName() == txtRecord.domainName()) {
                 sendTxt = true;
+            } else if (query.type() != ANY && query.domainName() == srvRecord.domainName()) {
+                negative = true;
             }
         }
 
         // Remove records to send if they are already known
+        bool knownPtr = false;
+        bool knownSrv = false;
+        bool knownTxt = false;
         const auto records = message.records();
         for (const Record &record : records) {
             if (record == ptrRecord) {
-                sendPtr = false;
+                knownPtr = true;
             } else if (record == srvRecord) {
-                sendSrv = false;
+                knownSrv = true;
             } else if (record == txtRecord) {
-                sendTxt = false;
+                knownTxt = true;
             }
         }
 
-        // Include the SRV and TXT if the PTR is being sent
+        server->countSuppressedRecords((sendPtr && knownPtr) + (sendSrv && knownSrv) + (sendTxt && knownTxt));
+
+        sendPtr = sendPtr && ! knownPtr;
+        sendSrv = sendSrv && ! knownSrv;
+        sendTxt = sendTxt && ! knownTxt;
+
+        if ( ! (sendBrowsePtr || sendPtr || sendSrv || sendTxt || negative))
+            return;
+
+        // Compose a message reply with the queried records as answers, and
+        // the records the peer will need next as additional records (RFC 6763
+        // §12): the SRV and TXT for a PTR, the addresses of the host for a SRV
+        Message reply;
+        reply.reply(message);
+        if (sendBrowsePtr)
+            reply.addRecord(browsePtrRecord);
+
         if (sendPtr)
-            sendSrv = sendTxt = true;
+            reply.addRecord(ptrRecord);
+
+        if (sendSrv)
+            reply.addRecord(srvRecord);
+
+        if (sendTxt)
+            reply.addRecord(txtRecord);
+
+        bool const additionalSrv = sendPtr && ! sendSrv && ! knownSrv;
+        bool const additionalTxt = sendPtr && ! sendTxt && ! knownTxt;
+        if (additionalSrv)
+            reply.addRecord(srvRecord, Message::Additional);
 
-        // If any records should be sent, compose a message reply
-        if (sendBrowsePtr || sendPtr || sendSrv || sendTxt) {
-            Message reply;
-            reply.reply(message);
-            if (sendBrowsePtr)
-                reply.addRecord(browsePtrRecord);
+        if (additionalTxt)
+            reply.addRecord(txtRecord, Message::Additional);
 
-            if (sendPtr)
-                reply.addRecord(ptrRecord);
+        // The service has no other record type: assert it so that peers do
+        // not query for them, as the answer when nothing else answers
+        if (sendPtr || sendSrv || sendTxt || negative) {
+            Message::Section const section = reply.records(Message::Answer).isEmpty()
+                    ? Message::Answer : Message::Additional;
+            reply.addRecord(nsecRecord(srvRecord.domainName(), {TXT, SRV}, srvRecord.ttl()), section);
+        }
 
-            if (sendSrv)
-                reply.addRecord(srvRecord);
+        if ((sendSrv || additionalSrv) && hostname)
+            addAddressRecords(reply, message.address());
 
-            if (sendTxt)
-                reply.addRecord(txtRecord);
+        server->sendMessage(reply);
+    }
 
-            server->sendMessage(reply);
+    // Add the addresses of the host to the additional section, with a NSEC
+    // record when it has none of a family
+    void addAddressRecords(Message& reply, QHostAddress const& peer)
+    {
+        QList<quint16> types;
+        const auto records = hostname->addressRecords(peer);
+        for (Record const& record : records) {
+            types.append(record.type());
+            reply.addRecord(record, Message::Additional);
         }
+        if ( ! records.isEmpty() && types.size() < 2)
+            reply.addRecord(nsecRecord(records.first().domainName(), types, records.first().ttl()), Message::Additional);
     }
 
     void onHostnameChanged(QByteArray const& newHostname)
@@ -211,13 +255,12 @@ void Provider::update(const Service &service)
     Q_D(Provider);
     d->initialized = true;
 
-    // Clean the service name
-    QByteArray const serviceName = service.name().replace('.', '-');
-
-    // Update the proposed records
-    QByteArray const fqName = serviceName + "." + service.type();
-    d->browsePtrProposed.setTarget(service.type());
-    d->ptrProposed.setName(service.type());
+    // Update the proposed records; the service name is a single label, dots
+    // included
+    DomainName const type(service.type());
+    DomainName const fqName = type.child(service.name());
+    d->browsePtrProposed.setTarget(type);
+    d->ptrProposed.setName(type);
     d->ptrProposed.setTarget(fqName);
     d->srvProposed.setName(fqName);
     d->srvProposed.setPort(service.port());
@@ -228,7 +271,7 @@ void Provider::update(const Service &service)
     // Assuming a valid hostname exists, check to see if the new service uses
     // a different name - if so, it must first be confirmed
     if (d->hostname->isRegistered()) {
-        if ( ! d->confirmed || (fqName != d->srvRecord.name()) ) {
+        if ( ! d->confirmed || (fqName != d->srvRecord.domainName()) ) {
             d->confirm();
         } else {
             d->publish();
@@ -1,6 +1,8 @@
 #include <qtmdns/dns.hpp>
 #include <qtmdns/query.hpp>
 
+#include "objectpool.hpp"
+
 #include <QByteArray>
 #include <QDebug>
 
@@ -9,7 +11,9 @@ namespace QtMdns {
 class QueryPrivate
 {
 public:
-    QByteArray name;
+    QTMDNS_POOLED_ALLOCATION(QueryPrivate)
+
+    DomainName name;
     quint16 type {0};
     bool unicastResponse {true};
 };
@@ -26,24 +30,48 @@ Query::Query(const Query &other) :
     *this = other;
 }
 
+Query::Query(Query &&other) :
+    dd_ptr(new QueryPrivate)
+{
+    dd_ptr.swap(other.dd_ptr);
+}
+
 Query &Query::operator=(const Query &other)
 {
     *dd_ptr = *other.dd_ptr;
     return *this;
 }
 
+Query &Query::operator=(Query &&other) noexcept
+{
+    dd_ptr.swap(other.dd_ptr);
+    return *this;
+}
+
 Query::~Query()
 {
 }
 
 
 QByteArray Query::name() const
+{
+    Q_D(const Query);
+    return d->name.toByteArray();
+}
+
+DomainName const& Query::domainName() const
 {
     Q_D(const Query);
     return d->name;
 }
 
 void Query::setName(const QByteArray &name)
+{
+    Q_D(Query);
+    d->name = DomainName(name);
+}
+
+void Query::setName(DomainName const& name)
 {
     Q_D(Query);
     d->name = name;
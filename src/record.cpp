@@ -5,26 +5,54 @@
 
 #include <QDebug>
 
+#include "objectpool.hpp"
+
+#include <type_traits>
+
 namespace QtMdns {
 
 class RecordPrivate
 {
 public:
-    QByteArray name;
+    QTMDNS_POOLED_ALLOCATION(RecordPrivate)
+
+    // Retrieve the data of the given kind, replacing the current one if it
+    // is of another kind; a target is kept when switching between PTR and SRV
+    template<class T>
+    T& rdataAs()
+    {
+        if (T* data = std::get_if<T>(&rdata))
+            return *data;
+
+        DomainName target;
+        if (PtrRdata const* ptr = std::get_if<PtrRdata>(&rdata))
+            target = ptr->target;
+        else if (SrvRdata const* srv = std::get_if<SrvRdata>(&rdata))
+            target = srv->target;
+
+        T& data = rdata.emplace<T>();
+        if constexpr (std::is_same_v<T, PtrRdata> || std::is_same_v<T, SrvRdata>)
+            data.target = target;
+        return data;
+    }
+
+    DomainName name;
     quint16 type {0};
     bool flushCache {false};
     quint32 ttl {3600};
-
-    QHostAddress address;
-    QByteArray target;
-    QByteArray nextDomainName;
-    quint16 priority {0};
-    quint16 weight {0};
-    quint16 port {0};
-    QMap<QByteArray, QByteArray> attributes;
-    Bitmap bitmap;
+    Rdata rdata;
 };
 
+namespace {
+
+DomainName const& nullDomainName()
+{
+    static DomainName const name;
+    return name;
+}
+
+} // namespace
+
 
 Record::Record() :
     dd_ptr(new RecordPrivate)
@@ -37,12 +65,24 @@ Record::Record(const Record &other) :
     *this = other;
 }
 
+Record::Record(Record &&other) :
+    dd_ptr(new RecordPrivate)
+{
+    dd_ptr.swap(other.dd_ptr);
+}
+
 Record& Record::operator=(const Record &other)
 {
     *dd_ptr = *other.dd_ptr;
     return *this;
 }
 
+Record& Record::operator=(Record &&other) noexcept
+{
+    dd_ptr.swap(other.dd_ptr);
+    return *this;
+}
+
 Record::~Record()
 {
 }
@@ -53,14 +93,7 @@ bool Record::operator==(const Record &other) const
     Q_D(const Record);
     return d->name == other.dd_ptr->name &&
         d->type == other.dd_ptr->type &&
-        d->address == other.dd_ptr->address &&
-        d->target == other.dd_ptr->target &&
-        d->nextDomainName == other.dd_ptr->nextDomainName &&
-        d->priority == other.dd_ptr->priority &&
-        d->weight == other.dd_ptr->weight &&
-        d->port == other.dd_ptr->port &&
-        d->attributes == other.dd_ptr->attributes &&
-        d->bitmap == other.dd_ptr->bitmap;
+        d->rdata == other.dd_ptr->rdata;
 }
 
 bool Record::operator!=(const Record &other) const
@@ -70,12 +103,24 @@ bool Record::operator!=(const Record &other) const
 
 
 QByteArray Record::name() const
+{
+    Q_D(const Record);
+    return d->name.toByteArray();
+}
+
+DomainName const& Record::domainName() const
 {
     Q_D(const Record);
     return d->name;
 }
 
 void Record::setName(const QByteArray &name)
+{
+    Q_D(Record);
+    d->name = DomainName(name);
+}
+
+void Record::setName(DomainName const& name)
 {
     Q_D(Record);
     d->name = name;
@@ -117,106 +162,152 @@ void Record::setTtl(quint32 ttl)
     d->ttl = ttl;
 }
 
-QHostAddress Record::address() const
+Rdata const& Record::rdata() const
 {
     Q_D(const Record);
-    return d->address;
+    return d->rdata;
+}
+
+void Record::setRdata(Rdata rdata)
+{
+    Q_D(Record);
+    d->rdata = std::move(rdata);
+}
+
+QHostAddress Record::address() const
+{
+    AddressRdata const* const data = rdataAs<AddressRdata>();
+    return data ? data->address : QHostAddress();
 }
 
 void Record::setAddress(const QHostAddress &address)
 {
     Q_D(Record);
-    d->address = address;
+    d->rdataAs<AddressRdata>().address = address;
 }
 
 QByteArray Record::target() const
 {
-    Q_D(const Record);
-    return d->target;
+    return targetName().toByteArray();
+}
+
+DomainName const& Record::targetName() const
+{
+    if (PtrRdata const* const ptr = rdataAs<PtrRdata>())
+        return ptr->target;
+    if (SrvRdata const* const srv = rdataAs<SrvRdata>())
+        return srv->target;
+    return nullDomainName();
 }
 
 void Record::setTarget(const QByteArray &target)
+{
+    setTarget(DomainName(target));
+}
+
+void Record::setTarget(DomainName const& target)
 {
     Q_D(Record);
-    d->target = target;
+    if (d->type == SRV || std::holds_alternative<SrvRdata>(d->rdata))
+        d->rdataAs<SrvRdata>().target = target;
+    else
+        d->rdataAs<PtrRdata>().target = target;
 }
 
 QByteArray Record::nextDomainName() const
 {
-    Q_D(const Record);
-    return d->nextDomainName;
+    NsecRdata const* const data = rdataAs<NsecRdata>();
+    return data ? data->nextDomainName.toByteArray() : QByteArray();
 }
 
 void Record::setNextDomainName(const QByteArray &nextDomainName)
 {
     Q_D(Record);
-    d->nextDomainName = nextDomainName;
+    d->rdataAs<NsecRdata>().nextDomainName = DomainName(nextDomainName);
 }
 
 quint16 Record::priority() const
 {
-    Q_D(const Record);
-    return d->priority;
+    SrvRdata const* const data = rdataAs<SrvRdata>();
+    return data ? data->priority : 0;
 }
 
 void Record::setPriority(quint16 priority)
 {
     Q_D(Record);
-    d->priority = priority;
+    d->rdataAs<SrvRdata>().priority = priority;
 }
 
 quint16 Record::weight() const
 {
-    Q_D(const Record);
-    return d->weight;
+    SrvRdata const* const data = rdataAs<SrvRdata>();
+    return data ? data->weight : 0;
 }
 
 void Record::setWeight(quint16 weight)
 {
     Q_D(Record);
-    d->weight = weight;
+    d->rdataAs<SrvRdata>().weight = weight;
 }
 
 quint16 Record::port() const
 {
-    Q_D(const Record);
-    return d->port;
+    SrvRdata const* const data = rdataAs<SrvRdata>();
+    return data ? data->port : 0;
 }
 
 void Record::setPort(quint16 port)
 {
     Q_D(Record);
-    d->port = port;
+    d->rdataAs<SrvRdata>().port = port;
 }
 
 QMap<QByteArray, QByteArray> Record::attributes() const
 {
-    Q_D(const Record);
-    return d->attributes;
+    TxtRdata const* const data = rdataAs<TxtRdata>();
+    return data ? data->txt.toMap() : QMap<QByteArray, QByteArray>();
 }
 
 void Record::setAttributes(const QMap<QByteArray, QByteArray> &attributes)
 {
     Q_D(Record);
-    d->attributes = attributes;
+    d->rdataAs<TxtRdata>().txt = TxtData::fromAttributes(attributes);
 }
 
 void Record::addAttribute(const QByteArray &key, const QByteArray &value)
 {
     Q_D(Record);
-    d->attributes.insert(key, value);
+    TxtData& txt = d->rdataAs<TxtRdata>().txt;
+    std::string_view const keyView(key.constData(), key.size());
+    txt.remove(keyView);
+    if (value.isNull())
+        txt.add(keyView);
+    else
+        txt.add(keyView, std::string_view(value.constData(), value.size()));
+}
+
+TxtData Record::txt() const
+{
+    TxtRdata const* const data = rdataAs<TxtRdata>();
+    return data ? data->txt : TxtData();
+}
+
+void Record::setTxt(TxtData const& txt)
+{
+    Q_D(Record);
+    d->rdataAs<TxtRdata>().txt = txt;
 }
 
 Bitmap Record::bitmap() const
 {
-    Q_D(const Record);
-    return d->bitmap;
+    NsecRdata const* const data = rdataAs<NsecRdata>();
+    return data ? data->bitmap : Bitmap();
 }
 
 void Record::setBitmap(const Bitmap &bitmap)
 {
     Q_D(Record);
-    d->bitmap = bitmap;
+    d->rdataAs<NsecRdata>().bitmap = bitmap;
 }
 
 
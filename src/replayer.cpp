@@ -0,0 +1,143 @@
+#include <qtmdns/browser.hpp>
+#include <qtmdns/cache.hpp>
+#include <qtmdns/localserver.hpp>
+#include <qtmdns/message.hpp>
+#include <qtmdns/record.hpp>
+#include <qtmdns/replayer.hpp>
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QtAlgorithms>
+
+namespace QtMdns {
+
+class ReplayerPrivate
+{
+public:
+    ReplayerPrivate() :
+        server(nullptr, QHostAddress(QHostAddress::LocalHost)),
+        cache(std::make_shared<Cache>())
+    {
+        // Milliseconds of the capture timestamp, the cache only needs that resolution
+        cache->setClock([this]() {
+            return QDateTime::fromMSecsSinceEpoch(now / 1000);
+        });
+    }
+
+    LocalServer server;
+    std::shared_ptr<Cache> cache;
+    QList<Browser*> browsers;
+    std::function<quint64()> allocationCounter;
+    qint64 now {0};  // Virtual time, microseconds since the Unix epoch
+};
+
+
+Replayer::Replayer(QObject* parent)
+    : QObject(parent),
+      dd_ptr(new ReplayerPrivate)
+{
+}
+
+Replayer::~Replayer()
+{
+    // Browsers reference the server and the cache
+    Q_D(Replayer);
+    qDeleteAll(d->browsers);
+}
+
+
+LocalServer* Replayer::server() const
+{
+    Q_D(const Replayer);
+    return const_cast<LocalServer*>(&d->server);
+}
+
+std::shared_ptr<Cache> Replayer::cache() const
+{
+    Q_D(const Replayer);
+    return d->cache;
+}
+
+Browser* Replayer::addBrowser(QByteArray const& type)
+{
+    Q_D(Replayer);
+    Browser* const browser = new Browser(&d->server, type, d->cache);
+    d->browsers.append(browser);
+    return browser;
+}
+
+void Replayer::setAllocationCounter(std::function<quint64()> counter)
+{
+    Q_D(Replayer);
+    d->allocationCounter = std::move(counter);
+}
+
+ReplayStatistics Replayer::replay(QList<TracedPacket> const& packets)
+{
+    Q_D(Replayer);
+    ReplayStatistics stats;
+
+    auto const connection = connect(&d->server, &AbstractServer::messageReceived, this,
+                                     [&stats](Message const& message) {
+        stats.records += message.records().count();
+    });
+
+    d->server.resetStatistics();
+    quint64 const allocationsBefore = d->allocationCounter ? d->allocationCounter() : 0;
+    qint64 firstTimestamp = -1;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (TracedPacket const& packet : packets) {
+        if (packet.direction != TracedPacket::Received)
+            continue;
+
+        if (firstTimestamp < 0)
+            firstTimestamp = packet.timestamp;
+        stats.captureDuration = packet.timestamp - firstTimestamp;
+
+        // Advance the virtual clock first, so records expire before newer
+        // ones are received, as they did during the capture
+        if (packet.timestamp > d->now) {
+            d->now = packet.timestamp;
+            d->cache->processTimeouts();
+        }
+
+        ++stats.packets;
+        stats.bytes += packet.data.size();
+        d->server.receivePacket(packet.data, packet.address, packet.port);
+    }
+
+    stats.elapsed = timer.nsecsElapsed();
+
+    if (d->allocationCounter)
+        stats.allocations = d->allocationCounter() - allocationsBefore;
+
+    disconnect(connection);
+
+    ServerStatistics const serverStats = d->server.statistics();
+    stats.messages = serverStats.queriesReceived + serverStats.responsesReceived;
+    for (quint64 failures : serverStats.parseFailures)
+        stats.parseFailures += failures;
+
+    if (stats.elapsed > 0)
+        stats.messagesPerSecond = stats.messages * 1e9 / stats.elapsed;
+
+    stats.cache = d->cache->statistics();
+    for (Browser const* browser : qAsConst(d->browsers)) {
+        BrowserStatistics const browserStats = browser->statistics();
+        stats.browsers.responsesProcessed += browserStats.responsesProcessed;
+        stats.browsers.queriesSent += browserStats.queriesSent;
+        stats.browsers.queriesSuppressed += browserStats.queriesSuppressed;
+        stats.browsers.knownAnswersSent += browserStats.knownAnswersSent;
+        stats.browsers.servicesAdded += browserStats.servicesAdded;
+        stats.browsers.servicesUpdated += browserStats.servicesUpdated;
+        stats.browsers.servicesRemoved += browserStats.servicesRemoved;
+    }
+
+    return stats;
+}
+
+} // namespace QtMdns
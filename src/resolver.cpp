@@ -1,19 +1,304 @@
 #include <qtmdns/abstractserver.hpp>
 #include <qtmdns/dns.hpp>
 #include <qtmdns/cache.hpp>
+#include <qtmdns/domainname.hpp>
+#include <qtmdns/mdns.hpp>
 #include <qtmdns/message.hpp>
 #include <qtmdns/query.hpp>
 #include <qtmdns/record.hpp>
 #include <qtmdns/resolver.hpp>
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QHostAddress>
 #include <QObject>
 #include <QPointer>
 #include <QSet>
-#include <QTimer>
+
+#include "timerqueue.hpp"
 
 namespace QtMdns {
 
+namespace {
+
+// Unanswered questions are sent again after 1 s, then the interval doubles
+constexpr qint64 FirstRetryInterval = 1000;
+
+} // namespace
+
+/**
+ * @brief Batch resolutions of a server
+ *
+ * All the resolutions started with Resolver::resolve() share a single timer,
+ * and the questions falling due together are sent in the same messages.
+ */
+class ResolveScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static ResolveScheduler* instance(AbstractServer* server)
+    {
+        ResolveScheduler* scheduler = server->findChild<ResolveScheduler*>(QString(), Qt::FindDirectChildrenOnly);
+        if ( ! scheduler)
+            scheduler = new ResolveScheduler(server);
+        return scheduler;
+    }
+
+    void add(QList<QByteArray> const& names, int timeout,
+             std::function<void(ResolveResult const&)> callback, std::shared_ptr<Cache> cache);
+
+private:
+    // Resolution of a single name
+    struct Host
+    {
+        QByteArray name;
+        QList<QHostAddress> addresses;
+        bool answeredA {false};     // A records received or ruled out
+        bool answeredAaaa {false};  // AAAA records received or ruled out
+
+        bool isSettled() const { return answeredA && answeredAaaa; }
+    };
+
+    struct Batch
+    {
+        QHash<DomainName, Host> hosts;
+        std::shared_ptr<Cache> cache;
+        std::function<void(ResolveResult const&)> callback;
+        qint64 deadline;   // Relative to clock
+        qint64 due;        // Time of the next questions, relative to clock
+        qint64 interval;   // Delay before the ones after
+        int sent {0};      // Rounds of questions sent
+
+        bool isSettled() const;
+        bool hasAddresses() const;
+    };
+
+    explicit ResolveScheduler(AbstractServer* server);
+
+    void schedule();
+    void onTimeout();
+    void onMessageReceived(Message const& message);
+    void complete(QList<Batch> const& finished, bool timedOut);
+    void send(QHash<DomainName, int> const& questions);
+
+    AbstractServer* const server;
+    QueuedTimer timer;
+    QElapsedTimer clock;
+    QList<Batch> batches;
+};
+
+
+bool ResolveScheduler::Batch::isSettled() const
+{
+    for (Host const& host : hosts) {
+        if ( ! host.isSettled())
+            return false;
+    }
+    return true;
+}
+
+bool ResolveScheduler::Batch::hasAddresses() const
+{
+    for (Host const& host : hosts) {
+        if (host.addresses.isEmpty())
+            return false;
+    }
+    return true;
+}
+
+ResolveScheduler::ResolveScheduler(AbstractServer* server) :
+    QObject(server),
+    server(server),
+    timer([this]() { onTimeout(); })
+{
+    connect(server, &AbstractServer::messageReceived, this, &ResolveScheduler::onMessageReceived);
+
+    // Retries can wait a little for other timeouts
+    timer.setServer(server);
+    timer.setSlack(100);
+    clock.start();
+}
+
+void ResolveScheduler::add(QList<QByteArray> const& names, int timeout,
+                           std::function<void(ResolveResult const&)> callback, std::shared_ptr<Cache> cache)
+{
+    qint64 const now = clock.elapsed();
+
+    Batch batch;
+    batch.cache = std::move(cache);
+    batch.callback = std::move(callback);
+    batch.deadline = now + qMax(0, timeout);
+    batch.due = now;
+    batch.interval = FirstRetryInterval;
+
+    for (QByteArray const& name : names) {
+        DomainName const domainName(name);
+        if (batch.hosts.contains(domainName))
+            continue;
+
+        // Start from the addresses, and the absence of addresses, already
+        // known; only the other families are queried
+        Host host;
+        host.name = name;
+        if (batch.cache) {
+            QList<Record> records;
+            batch.cache->lookupRecords(domainName, A, records);
+            batch.cache->lookupRecords(domainName, AAAA, records);
+            for (Record const& record : qAsConst(records)) {
+                if (record.domainName() != domainName || host.addresses.contains(record.address()))
+                    continue;
+                host.addresses.append(record.address());
+                (record.type() == A ? host.answeredA : host.answeredAaaa) = true;
+            }
+            host.answeredA = host.answeredA || batch.cache->isNegative(domainName, A);
+            host.answeredAaaa = host.answeredAaaa || batch.cache->isNegative(domainName, AAAA);
+        }
+        batch.hosts.insert(domainName, std::move(host));
+    }
+
+    // The first questions go out once control returns to the event loop,
+    // with those of the resolutions started meanwhile
+    batches.append(std::move(batch));
+    schedule();
+}
+
+void ResolveScheduler::schedule()
+{
+    if (batches.isEmpty()) {
+        timer.stop();
+        return;
+    }
+
+    qint64 next = qMin(batches.first().due, batches.first().deadline);
+    for (Batch const& batch : qAsConst(batches))
+        next = qMin(next, qMin(batch.due, batch.deadline));
+
+    timer.start(static_cast<int>(qMax<qint64>(0, next - clock.elapsed())));
+}
+
+void ResolveScheduler::onTimeout()
+{
+    qint64 const now = clock.elapsed();
+
+    QList<Batch> resolved;
+    QList<Batch> expired;
+    QHash<DomainName, int> questions;  // Bit 0 for A, bit 1 for AAAA
+
+    for (auto i = batches.begin(); i != batches.end();) {
+        bool const lastChance = i->due <= now || i->deadline <= now;
+        if (i->isSettled() || (lastChance && i->sent > 0 && i->hasAddresses())) {
+            // Hosts with an address had a full interval, or all the time
+            // left, to answer for the other family
+            resolved.append(std::move(*i));
+            i = batches.erase(i);
+        } else if (i->deadline <= now) {
+            expired.append(std::move(*i));
+            i = batches.erase(i);
+        } else {
+            if (i->due <= now) {
+                for (auto host = i->hosts.cbegin(); host != i->hosts.cend(); ++host) {
+                    int& types = questions[host.key()];
+                    types |= (host->answeredA ? 0 : 1) | (host->answeredAaaa ? 0 : 2);
+                }
+                ++i->sent;
+                i->due = now + i->interval;
+                i->interval *= 2;
+            }
+            ++i;
+        }
+    }
+
+    send(questions);
+    schedule();
+
+    complete(resolved, false);
+    complete(expired, true);
+}
+
+void ResolveScheduler::onMessageReceived(Message const& message)
+{
+    if ( ! message.isResponse() || batches.isEmpty())
+        return;
+
+    const auto records = message.records();
+    for (Record const& record : records) {
+        quint16 const type = record.type();
+        if (type != A && type != AAAA && type != NSEC)
+            continue;
+
+        for (Batch& batch : batches) {
+            auto const it = batch.hosts.find(record.domainName());
+            if (it == batch.hosts.end())
+                continue;
+
+            // A NSEC record rules out the families it does not list
+            Host& host = it.value();
+            if (type == NSEC) {
+                host.answeredA = host.answeredA || ! record.bitmap().contains(A);
+                host.answeredAaaa = host.answeredAaaa || ! record.bitmap().contains(AAAA);
+            } else if (record.ttl() > 0) {
+                (type == A ? host.answeredA : host.answeredAaaa) = true;
+                if ( ! host.addresses.contains(record.address()))
+                    host.addresses.append(record.address());
+            }
+
+            if (batch.cache)
+                batch.cache->addRecord(record);
+        }
+    }
+
+    QList<Batch> resolved;
+    for (auto i = batches.begin(); i != batches.end();) {
+        if (i->isSettled()) {
+            resolved.append(std::move(*i));
+            i = batches.erase(i);
+        } else {
+            ++i;
+        }
+    }
+
+    if ( ! resolved.isEmpty()) {
+        schedule();
+        complete(resolved, false);
+    }
+}
+
+void ResolveScheduler::complete(QList<Batch> const& finished, bool timedOut)
+{
+    // Batches are removed before their callbacks are called, as those may
+    // start new resolutions
+    for (Batch const& batch : finished) {
+        ResolveResult result;
+        result.timedOut = timedOut;
+        for (Host const& host : batch.hosts)
+            result.addresses.insert(host.name, host.addresses);
+
+        if (batch.callback)
+            batch.callback(result);
+    }
+}
+
+void ResolveScheduler::send(QHash<DomainName, int> const& questions)
+{
+    Message message;
+    for (auto it = questions.cbegin(); it != questions.cend(); ++it) {
+        for (quint16 const type : {A, AAAA}) {
+            if ( ! (it.value() & (type == A ? 1 : 2)))
+                continue;
+
+            Query query;
+                query.setName(it.key());
+                query.setType(type);
+            message.addQuery(std::move(query));
+        }
+    }
+
+    const auto messages = splitMessage(message, mdnsDefaults().MdnsMaxPacketSize);
+    for (Message const& part : messages)
+        server->sendMessageToAll(part);
+}
+
+
 class ResolverPrivate : public QObject
 {
     Q_DISABLE_COPY_MOVE(ResolverPrivate)
@@ -26,16 +311,21 @@ public:
         q_ptr(resolver),
         server(server),
         name(name),
-        cache(cache ? std::move(cache) : std::make_shared<Cache>())
+        domainName(name),
+        cache(cache ? cache : std::make_shared<Cache>()),
+        timer([this]() { onTimeout(); })
     {
         connect(server, &AbstractServer::messageReceived, this, &ResolverPrivate::onMessageReceived);
-        connect(&timer, &QTimer::timeout, this, &ResolverPrivate::onTimeout);
+
+        // A cache of its own is only used with this server
+        if ( ! cache)
+            this->cache->setTimerServer(server);
+        timer.setServer(server);
 
         // Query for new records
         query();
 
         // Pull the existing records from the cache
-        timer.setSingleShot(true);
         timer.start(0);
     }
 
@@ -49,15 +339,21 @@ public:
 
     void query() const
     {
-        // Add a query for A and AAAA records
-        Query query;
-            query.setName(name);
-            query.setType(A);
-
+        // Add a query for A and AAAA records, unless the host is known not to
+        // have addresses of that family
         Message message;
+        for (quint16 const type : {A, AAAA}) {
+            if (cache->isNegative(domainName, type))
+                continue;
+
+            Query query;
+                query.setName(name);
+                query.setType(type);
             message.addQuery(query);
-                query.setType(AAAA);
-            message.addQuery(query);
+        }
+
+        if (message.queries().isEmpty())
+            return;
 
         // Add existing (known) records to the query
         const auto records = existing();
@@ -77,7 +373,13 @@ public:
 
         const auto records = message.records();
         for (const Record &record : records) {
-            if (record.name() == name && (record.type() == A || record.type() == AAAA)) {
+            if (record.domainName() != domainName)
+                continue;
+
+            // Remember the address families the host does not have
+            if (record.type() == NSEC) {
+                cache->addRecord(record);
+            } else if (record.type() == A || record.type() == AAAA) {
                 cache->addRecord(record);
                 if ( ! addresses.contains(record.address())) {
                     emit q_ptr->resolved(record.address());
@@ -89,18 +391,24 @@ public:
 
     void onTimeout()
     {
+        // Addresses observed by a shared cache are no longer evicted
         const auto records = existing();
         for (const Record &record : records) {
-            emit q_ptr->resolved(record.address());
+            cache->retainRecord(record);
+            if ( ! addresses.contains(record.address())) {
+                emit q_ptr->resolved(record.address());
+                addresses.insert(record.address());
+            }
         }
     }
 
 private:
     QPointer<AbstractServer> server;
     QByteArray name;
+    DomainName domainName;
     std::shared_ptr<Cache> cache;
     QSet<QHostAddress> addresses;
-    QTimer timer;
+    QueuedTimer timer;
 };
 
 
@@ -120,4 +428,13 @@ Resolver::~Resolver()
 {
 }
 
+void Resolver::resolve(AbstractServer* server, const QList<QByteArray> &names, int timeout,
+                       std::function<void(const ResolveResult&)> callback,
+                       std::shared_ptr<Cache> cache)
+{
+    ResolveScheduler::instance(server)->add(names, timeout, std::move(callback), std::move(cache));
+}
+
 } // namespace QtMdns
+
+#include "resolver.moc"
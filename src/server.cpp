@@ -7,6 +7,7 @@
 
 #include <QHostAddress>
 #include <QLoggingCategory>
+#include <QNetworkDatagram>
 #include <QNetworkInterface>
 #include <QTimer>
 #include <QUdpSocket>
@@ -106,24 +107,30 @@ public:
         timer.start();
     }
 
+    bool sendDatagram(QUdpSocket& socket, QHostAddress const& addr, QByteArray const& packet, QNetworkInterface const& interface);
+
     void onReadyRead()
     {
         // Read the packet from the socket
         QUdpSocket* socket = qobject_cast<QUdpSocket*>(sender());
-        QByteArray packet;
-        packet.resize(socket->pendingDatagramSize());
+        QNetworkDatagram const datagram = socket->receiveDatagram();
+        QByteArray const packet = datagram.data();
 
-        QHostAddress address;
-        quint16 port;
-        socket->readDatagram(packet.data(), packet.size(), &address, &port);
+        q_ptr->countPacketReceived(packet.size(), datagram.interfaceIndex());
+        q_ptr->tracePacket(TracedPacket::Received, packet, datagram.senderAddress(),
+                           static_cast<quint16>(datagram.senderPort()), datagram.interfaceIndex());
 
         // Attempt to decode the packet
         Message message;
-        if (fromPacket(packet, message)) {
-            message.setAddress(address);
-            message.setPort(port);
+        ParseError error;
+        if (fromPacket(packet, message, error)) {
+            message.setAddress(datagram.senderAddress());
+            message.setPort(static_cast<quint16>(datagram.senderPort()));
 
+            q_ptr->countMessage(message, false);
             emit q_ptr->messageReceived(message);
+        } else {
+            q_ptr->countParseFailure(error);
         }
     }
 
@@ -143,6 +150,7 @@ Server::Server(QObject* parent) :
 
 Server::~Server()
 {
+    sendGoodbyes();
 }
 
 
@@ -150,24 +158,35 @@ void Server::sendMessage(const Message &message)
 {
     Q_D(Server);
     QByteArray const packet = toPacket(message);
+    countMessage(message, true);
 
+    qint64 written;
     if (message.address().protocol() == QAbstractSocket::IPv4Protocol) {
-        d->ipv4Socket.writeDatagram(packet, message.address(), message.port());
+        written = d->ipv4Socket.writeDatagram(packet, message.address(), message.port());
     } else {
-        d->ipv6Socket.writeDatagram(packet, message.address(), message.port());
+        written = d->ipv6Socket.writeDatagram(packet, message.address(), message.port());
     }
+    countPacketSent(packet.size(), 0, written > 0);
+    if (written > 0)
+        tracePacket(TracedPacket::Sent, packet, message.address(), message.port());
 }
 
-static bool sendDatagram(QUdpSocket& socket, QHostAddress const& addr, QByteArray const& packet, QNetworkInterface const& interface)
+bool ServerPrivate::sendDatagram(QUdpSocket& socket, QHostAddress const& addr, QByteArray const& packet, QNetworkInterface const& interface)
 {
     socket.setMulticastInterface(interface);
-    return socket.writeDatagram(packet, addr, mdnsDefaults().MdnsPort) > 0;
+    bool const sent = socket.writeDatagram(packet, addr, mdnsDefaults().MdnsPort) > 0;
+
+    q_ptr->countPacketSent(packet.size(), interface.index(), sent);
+    if (sent)
+        q_ptr->tracePacket(TracedPacket::Sent, packet, addr, mdnsDefaults().MdnsPort, interface.index());
+    return sent;
 }
 
 void Server::sendMessageToAll(const Message &message)
 {
     Q_D(Server);
     QByteArray const packet = toPacket(message);
+    countMessage(message, true);
 
     foreach (QNetworkInterface interface, QNetworkInterface::allInterfaces()) {
         if (interface.flags() & (QNetworkInterface::IsLoopBack | QNetworkInterface::IsPointToPoint))
@@ -177,15 +196,15 @@ void Server::sendMessageToAll(const Message &message)
 
         // Send and retry once "later" if failed.
         // On macOS, it may sometimes fail on first app start. An immediate re-send doesn't work.
-        if ( ! sendDatagram(d->ipv4Socket, mdnsDefaults().MdnsIpv4Address, packet, interface)) {
-            QTimer::singleShot(10, this, [interface, packet, socket=&d->ipv4Socket]() {
-                sendDatagram(*socket, mdnsDefaults().MdnsIpv4Address, packet, interface);
+        if ( ! d->sendDatagram(d->ipv4Socket, mdnsDefaults().MdnsIpv4Address, packet, interface)) {
+            QTimer::singleShot(10, this, [d, interface, packet]() {
+                d->sendDatagram(d->ipv4Socket, mdnsDefaults().MdnsIpv4Address, packet, interface);
             });
         }
 
-        if ( ! sendDatagram(d->ipv6Socket, mdnsDefaults().MdnsIpv6Address, packet, interface)) {
-            QTimer::singleShot(10, this, [interface, packet, socket=&d->ipv6Socket]() {
-                sendDatagram(*socket, mdnsDefaults().MdnsIpv6Address, packet, interface);
+        if ( ! d->sendDatagram(d->ipv6Socket, mdnsDefaults().MdnsIpv6Address, packet, interface)) {
+            QTimer::singleShot(10, this, [d, interface, packet]() {
+                d->sendDatagram(d->ipv6Socket, mdnsDefaults().MdnsIpv6Address, packet, interface);
             });
         }
 
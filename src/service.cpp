@@ -1,5 +1,13 @@
 #include <qtmdns/service.hpp>
 
+#include <QtGlobal>
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+#include <QRandomGenerator>
+#define USE_QRANDOMGENERATOR
+#endif
+
+#include <algorithm>
+
 namespace QtMdns {
 
 class ServicePrivate
@@ -9,8 +17,10 @@ public:
     QByteArray name;
     QByteArray hostname;
     quint16 port;
+    QList<ServiceTarget> targets;
     QHostAddress hostAddress;
     QHostAddress hostAddressIPv6;
+    QList<ServiceAddress> addresses;
     QMap<QByteArray, QByteArray> attributes;
 };
 
@@ -38,6 +48,8 @@ bool Service::operator==(const Service &other) const
     return d->type == other.dd_ptr->type &&
            d->name == other.dd_ptr->name &&
            d->port == other.dd_ptr->port &&
+           d->targets == other.dd_ptr->targets &&
+           d->addresses == other.dd_ptr->addresses &&
            d->attributes == other.dd_ptr->attributes;
 }
 
@@ -99,6 +111,62 @@ void Service::setPort(quint16 port)
     d->port = port;
 }
 
+QList<ServiceTarget> Service::targets() const
+{
+    Q_D(const Service);
+    return d->targets;
+}
+
+void Service::setTargets(const QList<ServiceTarget> &targets)
+{
+    Q_D(Service);
+    d->targets = targets;
+    if ( ! targets.isEmpty()) {
+        d->hostname = targets.first().hostname;
+        d->port = targets.first().port;
+    }
+}
+
+ServiceTarget Service::selectTarget() const
+{
+    Q_D(const Service);
+    if (d->targets.isEmpty())
+        return {d->hostname, d->port};
+
+    // Only targets of the lowest priority are candidates, those with a weight
+    // of 0 first so that a random sum of 0 can pick them
+    quint16 priority = d->targets.first().priority;
+    for (ServiceTarget const& target : d->targets)
+        priority = qMin(priority, target.priority);
+
+    QList<ServiceTarget> candidates;
+    quint32 total = 0;
+    for (ServiceTarget const& target : d->targets) {
+        if (target.priority != priority)
+            continue;
+        if (target.weight == 0)
+            candidates.prepend(target);
+        else
+            candidates.append(target);
+        total += target.weight;
+    }
+
+    // Pick the first target whose running sum of weights reaches a random
+    // number between 0 and the total
+#ifdef USE_QRANDOMGENERATOR
+    quint32 const random = QRandomGenerator::global()->bounded(total + 1);
+#else
+    quint32 const random = quint32(qrand()) % (total + 1);
+#endif
+    quint32 sum = 0;
+    for (ServiceTarget const& target : qAsConst(candidates)) {
+        sum += target.weight;
+        if (sum >= random)
+            return target;
+    }
+    return candidates.last();
+}
+
 QHostAddress const& Service::hostAddress() const
 {
     Q_D(const Service);
@@ -123,6 +191,31 @@ void Service::setHostAddressIPv6(QHostAddress const& address)
     d->hostAddressIPv6 = address;
 }
 
+QList<ServiceAddress> Service::addresses() const
+{
+    Q_D(const Service);
+    return d->addresses;
+}
+
+void Service::setAddresses(const QList<ServiceAddress> &addresses)
+{
+    Q_D(Service);
+    d->addresses = addresses;
+
+    QHostAddress ipv4;
+    QHostAddress ipv6;
+    for (ServiceAddress const& address : addresses) {
+        if (address.address.protocol() == QAbstractSocket::IPv4Protocol) {
+            if (ipv4.isNull())
+                ipv4 = address.address;
+        } else if (ipv6.isNull() || (ipv6.isLinkLocal() && ! address.address.isLinkLocal())) {
+            ipv6 = address.address;
+        }
+    }
+    d->hostAddress = ipv4;
+    d->hostAddressIPv6 = ipv6;
+}
+
 QMap<QByteArray, QByteArray> Service::attributes() const
 {
     Q_D(const Service);
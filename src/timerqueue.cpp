@@ -0,0 +1,162 @@
+#include <qtmdns/abstractserver.hpp>
+
+#include "timerqueue.hpp"
+
+namespace QtMdns {
+
+TimerQueue* TimerQueue::instance(AbstractServer* server)
+{
+    TimerQueue* queue = server->findChild<TimerQueue*>(QString(), Qt::FindDirectChildrenOnly);
+    if ( ! queue)
+        queue = new TimerQueue(server);
+    return queue;
+}
+
+TimerQueue::TimerQueue(AbstractServer* server) :
+    QObject(server)
+{
+    connect(&timer, &QTimer::timeout, this, &TimerQueue::onTimeout);
+
+    // The slack of the timeouts replaces the one of coarse timers
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    clock.start();
+}
+
+TimerQueue::Id TimerQueue::schedule(qint64 delay, qint64 slack, std::function<void()> callback)
+{
+    delay = qMax<qint64>(0, delay);
+    slack = qMax<qint64>(0, slack);
+    maxSlack = qMax(maxSlack, slack);
+
+    qint64 const due = clock.elapsed() + delay;
+    Id const id = ++lastId;
+    index.insert(id, entries.insert({due + slack, {id, due, std::move(callback)}}));
+
+    // Only a new first timeout changes the wakeup
+    if (entries.begin()->second.id == id)
+        wake();
+    return id;
+}
+
+void TimerQueue::cancel(Id id)
+{
+    auto const it = index.find(id);
+    if (it == index.end())
+        return;
+
+    bool const first = (it.value() == entries.begin());
+    entries.erase(it.value());
+    index.erase(it);
+    if (first)
+        wake();
+}
+
+void TimerQueue::wake()
+{
+    if (entries.empty()) {
+        timer.stop();
+        return;
+    }
+    timer.start(static_cast<int>(qMax<qint64>(0, entries.begin()->first - clock.elapsed())));
+}
+
+void TimerQueue::onTimeout()
+{
+    // Timeouts that are due can only be waiting until now + maxSlack at most
+    qint64 const now = clock.elapsed();
+    QList<Id> due;
+    for (auto it = entries.cbegin(); it != entries.cend() && it->first <= now + maxSlack; ++it) {
+        if (it->second.due <= now)
+            due.append(it->second.id);
+    }
+
+    // Callbacks may schedule or cancel timeouts, including the due ones
+    for (Id const id : qAsConst(due)) {
+        auto const it = index.find(id);
+        if (it == index.end())
+            continue;
+
+        std::function<void()> const callback = std::move(it.value()->second.callback);
+        entries.erase(it.value());
+        index.erase(it);
+        callback();
+    }
+
+    wake();
+}
+
+
+QueuedTimer::QueuedTimer(std::function<void()> callback) :
+    callback(std::move(callback))
+{
+}
+
+QueuedTimer::~QueuedTimer()
+{
+    stop();
+}
+
+void QueuedTimer::setServer(AbstractServer* server)
+{
+    stop();
+    queue = server ? TimerQueue::instance(server) : nullptr;
+}
+
+void QueuedTimer::setInterval(int msec)
+{
+    this->msec = msec;
+}
+
+int QueuedTimer::interval() const
+{
+    return msec;
+}
+
+void QueuedTimer::setSlack(int msec)
+{
+    slack = msec;
+}
+
+void QueuedTimer::start()
+{
+    start(msec);
+}
+
+void QueuedTimer::start(int msec)
+{
+    stop();
+    this->msec = msec;
+
+    if (queue) {
+        id = queue->schedule(msec, slack, [this]() {
+            id = 0;
+            callback();
+        });
+        return;
+    }
+
+    if ( ! fallback) {
+        fallback.reset(new QTimer);
+        fallback->setSingleShot(true);
+        QObject::connect(fallback.get(), &QTimer::timeout, fallback.get(), [this]() { callback(); });
+    }
+    fallback->start(msec);
+}
+
+void QueuedTimer::stop()
+{
+    if (id && queue)
+        queue->cancel(id);
+    id = 0;
+
+    if (fallback)
+        fallback->stop();
+}
+
+bool QueuedTimer::isActive() const
+{
+    return (id != 0 && queue) || (fallback && fallback->isActive());
+}
+
+} // namespace QtMdns
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include <functional>
+#include <map>
+#include <memory>
+
+namespace QtMdns {
+
+class AbstractServer;
+
+/**
+ * @brief Timeouts of all the components of a server
+ *
+ * Browsers, caches, resolvers, probers, hostnames and announcers schedule
+ * their timeouts with the queue of their server instead of each owning Qt
+ * timers, so that a server holds a single Qt timer however many components
+ * use it.
+ *
+ * Each timeout may be delayed by a slack of its own. The queue wakes up when
+ * the first timeout can wait no longer, and then runs every timeout that is
+ * due: timeouts close to each other share a wakeup.
+ */
+class TimerQueue : public QObject
+{
+    Q_OBJECT
+public:
+    using Id = quint64;
+
+    /**
+     * @brief Retrieve the queue of a server, creating it if needed
+     */
+    static TimerQueue* instance(AbstractServer* server);
+
+    /**
+     * @brief Call a function after a delay
+     * @param delay delay in milliseconds
+     * @param slack additional delay in milliseconds allowed to share a wakeup
+     * @param callback function to call
+     * @return identifier of the timeout, never 0
+     */
+    Id schedule(qint64 delay, qint64 slack, std::function<void()> callback);
+
+    /**
+     * @brief Cancel a timeout that has not run yet
+     */
+    void cancel(Id id);
+
+private:
+    explicit TimerQueue(AbstractServer* server);
+
+    struct Entry
+    {
+        Id id;
+        qint64 due;   // Earliest time to run, relative to clock
+        std::function<void()> callback;
+    };
+    using Entries = std::multimap<qint64, Entry>;  // By latest time to run
+
+    void wake();
+    void onTimeout();
+
+    QTimer timer;
+    QElapsedTimer clock;
+    Entries entries;
+    QHash<Id, Entries::iterator> index;
+    qint64 maxSlack {0};
+    Id lastId {0};
+};
+
+/**
+ * @brief Single-shot timer scheduled with the queue of a server
+ *
+ * This is the subset of QTimer the components use. Without a server, the
+ * timer falls back to a QTimer of its own.
+ */
+class QueuedTimer
+{
+    Q_DISABLE_COPY_MOVE(QueuedTimer)
+public:
+    explicit QueuedTimer(std::function<void()> callback);
+    ~QueuedTimer();
+
+    /**
+     * @brief Schedule with the queue of a server, stopping the timer
+     */
+    void setServer(AbstractServer* server);
+
+    void setInterval(int msec);
+    int interval() const;
+
+    /**
+     * @brief Set how many milliseconds the timeout may be delayed by
+     */
+    void setSlack(int msec);
+
+    void start();
+    void start(int msec);
+    void stop();
+    bool isActive() const;
+
+private:
+    std::function<void()> callback;
+    QPointer<TimerQueue> queue;
+    std::unique_ptr<QTimer> fallback;
+    TimerQueue::Id id {0};
+    int msec {0};
+    int slack {0};
+};
+
+} // namespace QtMdns
@@ -0,0 +1,203 @@
+#include <qtmdns/txtdata.hpp>
+
+#include <QSet>
+
+namespace QtMdns {
+
+namespace {
+
+constexpr std::size_t MaxStringLength = 255;
+
+char foldCase(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+bool keysEqual(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (foldCase(a[i]) != foldCase(b[i]))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+TxtData::const_iterator::const_iterator(char const* position, char const* end) :
+    m_position(position),
+    m_end(end)
+{
+    read();
+}
+
+TxtData::const_iterator& TxtData::const_iterator::operator++()
+{
+    m_position += 1 + static_cast<quint8>(*m_position);
+    read();
+    return *this;
+}
+
+TxtData::const_iterator TxtData::const_iterator::operator++(int)
+{
+    const_iterator const previous = *this;
+    ++*this;
+    return previous;
+}
+
+void TxtData::const_iterator::read()
+{
+    // Skip empty strings and entries without a key; a string running past
+    // the end of the data ends the iteration
+    while (m_position != m_end) {
+        std::size_t const length = static_cast<quint8>(*m_position);
+        if (length >= static_cast<std::size_t>(m_end - m_position)) {
+            m_position = m_end;
+            break;
+        }
+
+        std::string_view const string(m_position + 1, length);
+        std::size_t const split = string.find('=');
+        if (split == 0 || length == 0) {
+            m_position += 1 + length;
+            continue;
+        }
+
+        if (split == std::string_view::npos)
+            m_entry = TxtEntry(string, std::string_view(), false);
+        else
+            m_entry = TxtEntry(string.substr(0, split), string.substr(split + 1), true);
+        return;
+    }
+    m_entry = TxtEntry();
+}
+
+
+TxtData::TxtData(QByteArray const& data) :
+    m_data(data)
+{
+}
+
+TxtData TxtData::fromAttributes(QMap<QByteArray, QByteArray> const& attributes)
+{
+    TxtData txt;
+    for (auto i = attributes.constBegin(); i != attributes.constEnd(); ++i) {
+        std::string_view const key(i.key().constData(), i.key().size());
+        if (i.value().isNull())
+            txt.add(key);
+        else
+            txt.add(key, std::string_view(i.value().constData(), i.value().size()));
+    }
+    return txt;
+}
+
+bool TxtData::isValid() const
+{
+    qsizetype i = 0;
+    while (i < m_data.size())
+        i += 1 + static_cast<quint8>(m_data.at(i));
+    return i == m_data.size();
+}
+
+int TxtData::count() const
+{
+    int count = 0;
+    for (auto i = begin(); i != end(); ++i)
+        ++count;
+    return count;
+}
+
+TxtData::const_iterator TxtData::begin() const
+{
+    return const_iterator(m_data.constData(), m_data.constData() + m_data.size());
+}
+
+TxtData::const_iterator TxtData::end() const
+{
+    char const* const end = m_data.constData() + m_data.size();
+    return const_iterator(end, end);
+}
+
+std::optional<TxtEntry> TxtData::find(std::string_view key) const
+{
+    for (TxtEntry const& entry : *this) {
+        if (keysEqual(entry.key(), key))
+            return entry;
+    }
+    return std::nullopt;
+}
+
+QByteArray TxtData::value(std::string_view key) const
+{
+    std::optional<TxtEntry> const entry = find(key);
+    if ( ! entry || ! entry->hasValue())
+        return QByteArray();
+
+    // The value points into the data even when empty, so the array is not null
+    return QByteArray(entry->value().data(), static_cast<qsizetype>(entry->value().size()));
+}
+
+QMap<QByteArray, QByteArray> TxtData::toMap() const
+{
+    QMap<QByteArray, QByteArray> attributes;
+    QSet<QByteArray> keys;
+    for (TxtEntry const& entry : *this) {
+        QByteArray const key(entry.key().data(), static_cast<qsizetype>(entry.key().size()));
+        QByteArray const folded = key.toLower();
+        if (keys.contains(folded))
+            continue;
+        keys.insert(folded);
+
+        if (entry.hasValue())
+            attributes.insert(key, QByteArray(entry.value().data(), static_cast<qsizetype>(entry.value().size())));
+        else
+            attributes.insert(key, QByteArray());
+    }
+    return attributes;
+}
+
+bool TxtData::add(std::string_view key)
+{
+    return append(key, nullptr);
+}
+
+bool TxtData::add(std::string_view key, std::string_view value)
+{
+    return append(key, &value);
+}
+
+void TxtData::remove(std::string_view key)
+{
+    QByteArray data;
+    data.reserve(m_data.size());
+    qsizetype i = 0;
+    while (i < m_data.size()) {
+        qsizetype const length = static_cast<quint8>(m_data.at(i));
+        std::string_view const string(m_data.constData() + i + 1, static_cast<std::size_t>(qMin(length, m_data.size() - i - 1)));
+        if ( ! keysEqual(string.substr(0, string.find('=')), key))
+            data.append(m_data.constData() + i, 1 + string.size());
+        i += 1 + length;
+    }
+    m_data = data;
+}
+
+bool TxtData::append(std::string_view key, std::string_view const* value)
+{
+    std::size_t const length = key.size() + (value ? 1 + value->size() : 0);
+    if (key.empty() || key.find('=') != std::string_view::npos || length > MaxStringLength)
+        return false;
+
+    // Write the string in place, without building it first
+    m_data.append(static_cast<char>(length));
+    m_data.append(key.data(), static_cast<qsizetype>(key.size()));
+    if (value) {
+        m_data.append('=');
+        m_data.append(value->data(), static_cast<qsizetype>(value->size()));
+    }
+    return true;
+}
+
+} // namespace QtMdns